@@ -0,0 +1,44 @@
+;; Integers past the fixnums: factorial of 10000 (a bignum times a fixnum
+;; at every step), the 100000th Fibonacci number (bignum additions) and
+;; products of bignums of the same size, which use Karatsuba's method
+
+(defun (factorial n)
+    (let ((res 1))
+      (begin
+       (dotimes (i n) (setq res (* res (+ i 1))))
+       res)))
+
+;; the same product, as a balanced tree of products of big halves
+(defun (range-product from to)
+    (if (> (- to from) 8)
+        (let ((mid (/ (+ from to) 2)))
+          (* (range-product from mid) (range-product (+ mid 1) to)))
+      (let ((res from))
+        (begin
+         (dotimes (i (- to from)) (setq res (* res (+ from (+ i 1)))))
+         res))))
+
+(defun (fib n)
+    (let ((a 0) (b 1) (next 0))
+      (begin
+       (dotimes (i n)
+         (begin (setq next (+ a b)) (setq a b) (setq b next)))
+       a)))
+
+(print "factorial 10000: " (timeit (factorial 10000)) " ms")
+(print "factorial 10000 as a product tree: "
+       (timeit (range-product 1 10000)) " ms")
+(print "factorial 10000 modulo 1000000007: "
+       (remainder (factorial 10000) 1000000007))
+(print "fib 100000: " (timeit (fib 100000)) " ms")
+(print "fib 100000 modulo 1000000007: " (remainder (fib 100000) 1000000007))
+
+(setq three 3)
+(setq a (- (** three 200000) 1))
+(setq b (+ (** 7 100000) 1))
+(print "product of two 10000-limb bignums 10 iterations: "
+       (timeit (dotimes (i 10) (* a b))) " ms")
+(print "(** 3 1000000): " (timeit (** three 1000000)) " ms")
+(print "to-string of 3^200000: " (timeit (to-string a)) " ms")
+(print "division of 3^200000 by 7^50000: "
+       (timeit (/ a (** 7 50000))) " ms")
@@ -0,0 +1,14 @@
+;; Calls to built-ins, whose number of arguments is checked once per call
+;; site rather than on every call
+
+(defun (fib n)
+    (if (< n 2)
+        n
+      (+ (fib (- n 1)) (fib (- n 2)))))
+(print "fib 27 iterations: " (timeit (fib 27)) " ms")
+
+(setq items '(1 2 3))
+(setq total 0)
+(print "car 1000000 iterations: "
+       (timeit (dotimes (i 1000000) (setq total (+ total (car items)))))
+       " ms")
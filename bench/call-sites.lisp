@@ -0,0 +1,13 @@
+;; Calls through global function names, with the tree-walker (-t) every
+;; call site resolves its callee through its inline cache
+
+(defun (fib n)
+    (if (< n 2)
+        n
+      (+ (fib (- n 1)) (fib (- n 2)))))
+(print "fib 25 iterations: " (timeit (fib 25)) " ms")
+
+(defun (twice x) (* x 2))
+(setq total 0)
+(print "global call 1000000 iterations: "
+       (timeit (dotimes (i 1000000) (setq total (twice i)))) " ms")
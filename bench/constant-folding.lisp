@@ -0,0 +1,16 @@
+;; Constant expressions evaluated in a loop, folded once before the
+;; evaluation (compare with --no-fold)
+
+(setq total 0)
+(print "constant arithmetic 1000000 iterations: "
+       (timeit (dotimes (i 1000000)
+                 (setq total (+ total (* (* 128 16) (- 10 (/ 8 2)))))))
+       " ms")
+
+(setq total 0)
+(print "constant conditions 1000000 iterations: "
+       (timeit (dotimes (i 1000000)
+                 (if (< 1 2)
+                     (setq total (+ total 1))
+                   (setq total (- total 1)))))
+       " ms")
@@ -0,0 +1,9 @@
+;; Non-tail recursion, the frames are kept on the VM stack instead of the
+;; C++ one
+
+(defun (depth n)
+    (if (= n 0)
+        0
+      (+ 1 (depth (- n 1)))))
+
+(print "depth 1000000 iterations: " (timeit (depth 1000000)) " ms")
@@ -0,0 +1,24 @@
+;; eval of a short string in a loop, before and after filling the heap:
+;; the nested reader only saves a pointer, so both should take the same.
+;; Evaluating the same text again reuses its form from the eval cache,
+;; new texts are read every time.
+
+(print "eval 100000 iterations: "
+       (timeit (dotimes (i 100000) (eval "(+ 1 2)"))) " ms")
+
+(setq keep (make-hash-table))
+(dotimes (i 200000) (set-hash keep i (to-string i)))
+(print "eval 100000 iterations, 200000 more live objects: "
+       (timeit (dotimes (i 100000) (eval "(+ 1 2)"))) " ms")
+
+(setq text "(begin (setq a (+ 1 2)) (setq b (* a (- a 1))) (if (< a b) a b))")
+(print "eval of a longer text 100000 iterations: "
+       (timeit (dotimes (i 100000) (eval text))) " ms")
+
+(setq texts (make-hash-table))
+(dotimes (i 1000) (set-hash texts i (+ "(+ 1 " (+ (to-string i) ")"))))
+(print "eval of 1000 different texts 100 times: "
+       (timeit (dotimes (j 100)
+                 (dotimes (i 1000) (eval (get-hash texts i)))))
+       " ms")
+(print (eval-cache-stats))
@@ -0,0 +1,21 @@
+;; Short-lived garbage next to a small live set, the collector runs every few
+;; megabytes allocated
+
+(defun (make-garbage n acc)
+    (if (= n 0)
+        acc
+      (make-garbage (- n 1) (cons (to-string n) acc))))
+
+(defun (churn n)
+    (if (= n 0)
+        nil
+      (begin
+       (make-garbage 10 '())
+       (churn (- n 1)))))
+
+(print "churn 200000 iterations: " (timeit (churn 200000)) " ms")
+(setq stats (gc-stats))
+(print "collections: " (get-hash stats "cycles")
+       ", max pause: " (get-hash stats "max-pause") " us"
+       ", total pause: " (get-hash stats "total-pause") " us")
+(print "heap pages: " (get-hash (heap-stats) "pages"))
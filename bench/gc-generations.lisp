@@ -0,0 +1,33 @@
+;; List temporaries (every cdr copies the rest of the list) churned next to
+;; a long-lived table. Compare the collectors with
+;; ./scripts/compare-gc.sh
+
+(defun (make-list n)
+    (if (= n 0)
+        '()
+      (cons n (make-list (- n 1)))))
+
+(setq live (make-hash-table))
+(defun (fill-live n)
+    (if (= n 0)
+        nil
+      (begin
+       (set-hash live n (make-list 20))
+       (fill-live (- n 1)))))
+(fill-live 20000)
+
+(setq items (make-list 30))
+(defun (churn n)
+    (if (= n 0)
+        nil
+      (begin
+       (map (lambda (x) (* x 2)) items)
+       (churn (- n 1)))))
+
+(print "map 20000 iterations: " (timeit (churn 20000)) " ms")
+(setq stats (gc-stats))
+(print "collections: " (get-hash stats "minor-cycles") " minor, "
+       (get-hash stats "major-cycles") " major")
+(print "p99 pause: " (get-hash stats "p99-pause")
+       " us, max pause: " (get-hash stats "max-pause")
+       " us, total pause: " (get-hash stats "total-pause") " us")
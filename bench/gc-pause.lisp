@@ -0,0 +1,34 @@
+;; Pause times with a big live set: a table of 1M entries (~220 MB of
+;; objects) is built and then strings are churned next to it. The pauses
+;; should stay around the budget given with --gc-pause-ms (5 ms by default)
+;; whatever the size of the heap, the slices are logged to lisp-gc.log.
+
+(defun (make-strs n acc)
+    (if (= n 0)
+        acc
+      (make-strs (- n 1) (cons acc (to-string n)))))
+
+(setq live (make-hash-table))
+(defun (fill-live n)
+    (if (= n 0)
+        nil
+      (begin
+       (set-hash live n (make-strs 8 '()))
+       (fill-live (- n 1)))))
+(print "fill 1000000 entries: " (timeit (fill-live 1000000)) " ms")
+(print "bytes in use: " (get-hash (heap-stats) "bytes-in-use"))
+
+(defun (churn n)
+    (if (= n 0)
+        nil
+      (begin
+       (make-strs 8 '())
+       (churn (- n 1)))))
+(print "churn 2000000 iterations: " (timeit (churn 2000000)) " ms")
+
+(setq stats (gc-stats))
+(print "collections: " (get-hash stats "minor-cycles") " minor, "
+       (get-hash stats "major-cycles") " major")
+(print "p99 pause: " (get-hash stats "p99-pause")
+       " us, max pause: " (get-hash stats "max-pause")
+       " us, total pause: " (get-hash stats "total-pause") " us")
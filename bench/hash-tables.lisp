@@ -0,0 +1,25 @@
+;; Inserting, looking up and removing 10M integer keys, then 10M string
+;; keys
+
+(setq n 10000000)
+
+(setq numbers (make-hash-table))
+(print "insert " n " integer keys: "
+       (timeit (dotimes (i n) (set-hash numbers i i))) " ms")
+(setq found 0)
+(print "look up " n " integer keys: "
+       (timeit (dotimes (i n) (setq found (get-hash numbers i)))) " ms")
+(print "remove " n " integer keys: "
+       (timeit (dotimes (i n) (remove-hash numbers i))) " ms")
+(setq numbers nil)
+
+(setq keys (make-hash-table))
+(dotimes (i n) (set-hash keys i (+ "key-" (to-string i))))
+(setq strings (make-hash-table))
+(print "insert " n " string keys: "
+       (timeit (dotimes (i n) (set-hash strings (get-hash keys i) i))) " ms")
+(print "look up " n " string keys: "
+       (timeit (dotimes (i n) (setq found (get-hash strings (get-hash keys i)))))
+       " ms")
+(print "remove " n " string keys: "
+       (timeit (dotimes (i n) (remove-hash strings (get-hash keys i)))) " ms")
@@ -0,0 +1,43 @@
+;; The built-in list library against the Lisp versions in stdlib/basic.lisp,
+;; over a list of 10000 numbers
+
+(defun (make-list n)
+    (cond
+     ((= n 0) '())
+     ((= (remainder n 2) 0)
+      (let ((half (make-list (/ n 2))))
+        (cons half half)))
+     (else (cons 1 (make-list (- n 1))))))
+
+(setq items (make-list 10000))
+
+(defun (repeat n f)
+    (if (= n 0)
+        nil
+      (begin
+       (f)
+       (repeat (- n 1) f))))
+
+(defun (double x) (* x 2))
+(defun (add acc x) (+ acc x))
+
+(print "length 100 iterations: "
+       (timeit (repeat 100 (lambda () (length items)))) " ms")
+(print "lisp-length 100 iterations: "
+       (timeit (repeat 100 (lambda () (lisp-length items)))) " ms")
+(print "reverse 100 iterations: "
+       (timeit (repeat 100 (lambda () (reverse items)))) " ms")
+(print "lisp-reverse 1 iterations: "
+       (timeit (lisp-reverse items)) " ms")
+(print "append 100 iterations: "
+       (timeit (repeat 100 (lambda () (append items items)))) " ms")
+(print "lisp-append 1 iterations: "
+       (timeit (lisp-append items items)) " ms")
+(print "map 100 iterations: "
+       (timeit (repeat 100 (lambda () (map double items)))) " ms")
+(print "lisp-map 1 iterations: "
+       (timeit (lisp-map double items)) " ms")
+(print "accumulate 100 iterations: "
+       (timeit (repeat 100 (lambda () (accumulate add items 0)))) " ms")
+(print "lisp-accumulate 10 iterations: "
+       (timeit (repeat 10 (lambda () (lisp-accumulate add items 0)))) " ms")
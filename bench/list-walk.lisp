@@ -0,0 +1,25 @@
+;; Walks a long list with the Lisp versions of the list library, every step
+;; takes the cdr of the list. The list has 100000 elements.
+
+;; n numbers, built by doubling so that it only copies O(n) members
+(defun (make-list n)
+    (cond
+     ((= n 0) '())
+     ((= (remainder n 2) 0)
+      (let ((half (make-list (/ n 2))))
+        (cons half half)))
+     (else (cons 1 (make-list (- n 1))))))
+
+(setq items (make-list 100000))
+(print "lisp-length 100000 elements: " (lisp-length items))
+
+(defun (walk n)
+    (if (= n 0)
+        nil
+      (begin
+       (lisp-length items)
+       (walk (- n 1)))))
+
+(print "lisp-length 10 iterations: " (timeit (walk 10)) " ms")
+(print "lisp-accumulate 100000 elements: "
+       (timeit (lisp-accumulate (lambda (acc x) (+ acc x)) items 0)) " ms")
@@ -0,0 +1,32 @@
+;; Counter loops with the loop forms against the recursive equivalents
+
+(setq total 0)
+(print "dotimes 10000000 iterations: "
+       (timeit (dotimes (i 10000000) (setq total (+ total 1)))) " ms")
+
+(setq i 0)
+(print "while 10000000 iterations: "
+       (timeit (while (< i 10000000) (setq i (+ i 1)))) " ms")
+
+(defun (count-up i n acc)
+    (if (= i n)
+        acc
+      (count-up (+ i 1) n (+ acc 1))))
+(print "recursion 10000000 iterations: " (timeit (count-up 0 10000000 0)) " ms")
+
+(defun (grow l k)
+    (if (= k 0)
+        l
+      (grow (append l l) (- k 1))))
+(setq items (grow '(1 2 3 4 5 6 7 8 9 10) 17))
+(setq sum 0)
+(print "dolist 1310720 iterations: "
+       (timeit (dolist (x items) (setq sum (+ sum x)))) " ms")
+(setq sum 0)
+(print "for-each 1310720 iterations: "
+       (timeit (for-each (lambda (x) (setq sum (+ sum x))) items)) " ms")
+
+(setq before (objects-allocated))
+(dotimes (i 1000000) (setq total (+ total 1)))
+(print "objects allocated by 1000000 iterations: "
+       (- (objects-allocated) before))
@@ -0,0 +1,22 @@
+;; The same recursive functions plain and memoized, the memoized fib makes
+;; one call per distinct argument
+
+(defun (fib n)
+    (if (< n 2)
+        n
+      (+ (fib (- n 1)) (fib (- n 2)))))
+(print "plain fib 27: " (timeit (fib 27)) " ms")
+
+(defun-memo (memo-fib n)
+    (if (< n 2)
+        n
+      (+ (memo-fib (- n 1)) (memo-fib (- n 2)))))
+(print "memoized fib 27: " (timeit (memo-fib 27)) " ms")
+
+(defun (paths a b)
+    (cond ((= a 0) 1)
+          ((= b 0) 1)
+          (else (+ (paths (- a 1) b) (paths a (- b 1))))))
+(setq memo-paths (memoize paths))
+(print "cached calls 100000 iterations: "
+       (timeit (dotimes (i 100000) (memo-paths 8 8))) " ms")
@@ -0,0 +1,36 @@
+;; Summing and combining a million numbers, as a list walked by the
+;; interpreter and as numeric vectors. Run with --no-simd to compare the
+;; vector kernels with plain loops.
+
+(setq n 1000000)
+(setq v (make-i64vector n))
+(dotimes (i n) (vec-set v i (remainder i 10)))
+(setq f (make-f64vector n))
+(dotimes (i n) (vec-set f i (remainder i 10)))
+(setq l (vec->list v))
+
+(defun (list-sum xs)
+    (let ((total 0))
+      (begin
+       (dolist (x xs) (setq total (+ total x)))
+       total)))
+(defun (loop-dot a b)
+    (let ((total 0))
+      (begin
+       (dotimes (i (vec-length a))
+         (setq total (+ total (* (vec-ref a i) (vec-ref b i)))))
+       total)))
+
+(print "list sum: " (timeit (list-sum l)) " ms")
+(print "vec-ref loop dot: " (timeit (loop-dot v v)) " ms")
+(print "i64 vec-sum x100: " (timeit (dotimes (i 100) (vec-sum v))) " ms")
+(print "f64 vec-sum x100: " (timeit (dotimes (i 100) (vec-sum f))) " ms")
+(print "i64 vec-dot x100: " (timeit (dotimes (i 100) (vec-dot v v))) " ms")
+(print "f64 vec-dot x100: " (timeit (dotimes (i 100) (vec-dot f f))) " ms")
+(print "i64 vec-max x100: " (timeit (dotimes (i 100) (vec-max v))) " ms")
+(print "i64 vec-add x100: " (timeit (dotimes (i 100) (vec-add v v))) " ms")
+(print "f64 vec-mul x100: " (timeit (dotimes (i 100) (vec-mul f f))) " ms")
+(print "i64 vec-prefix-sum x100: "
+       (timeit (dotimes (i 100) (vec-prefix-sum v))) " ms")
+(print "sums: " (list-sum l) " " (vec-sum v) " " (vec-sum f) ", dots: "
+       (loop-dot v v) " " (vec-dot v v))
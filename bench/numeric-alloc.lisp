@@ -0,0 +1,20 @@
+;; Heap objects allocated by numeric code, numbers are immediate values and
+;; shouldn't allocate at all
+
+(defun (fib n)
+    (if (< n 2)
+        n
+      (+ (fib (- n 1)) (fib (- n 2)))))
+
+(defun (sum-to n acc)
+    (if (= n 0)
+        acc
+      (sum-to (- n 1) (+ acc n))))
+
+(setq before (objects-allocated))
+(print "fib 25: " (timeit (fib 25)) " ms")
+(print "fib 25 allocated objects: " (- (objects-allocated) before))
+
+(setq before (objects-allocated))
+(print "sum-to 1000000 iterations: " (timeit (sum-to 1000000 0)) " ms")
+(print "sum-to 1000000 allocated objects: " (- (objects-allocated) before))
@@ -0,0 +1,37 @@
+;; Building a 1M-entry persistent map, then keeping 1000 versions of it,
+;; each one with an entry more than the one before. The versions share all
+;; but the path to their new entry, where a copy of the whole map per
+;; version would take 1000 times the memory of the first one.
+
+(setq n 1000000)
+(setq versions 1000)
+
+(defun (kilobytes) (/ (memtotal) 1024))
+
+(setq before (kilobytes))
+(setq m (make-persistent-map))
+(print "assoc " n " integer keys: "
+       (timeit (dotimes (i n) (setq m (assoc m i i)))) " ms")
+(setq one-map (- (kilobytes) before))
+(print "memory of the map: " one-map " KB")
+(setq found 0)
+(print "look up " n " integer keys: "
+       (timeit (dotimes (i n) (setq found (lookup m i)))) " ms")
+
+(setq kept (make-hash-table))
+(setq before (kilobytes))
+(setq objects-before (objects-allocated))
+(print "keep " versions " versions: "
+       (timeit (dotimes (i versions)
+                 (setq m (assoc m (+ n i) i))
+                 (set-hash kept i m)))
+       " ms")
+(print "memory of the " versions " versions: " (- (kilobytes) before)
+       " KB in " (- (objects-allocated) objects-before)
+       " objects, copies would take about " (* one-map versions) " KB")
+(print "entries of the first and last versions: "
+       (map-count (get-hash kept 0)) " "
+       (map-count (get-hash kept (- versions 1))))
+
+(print "dissoc " n " integer keys: "
+       (timeit (dotimes (i n) (setq m (dissoc m i)))) " ms")
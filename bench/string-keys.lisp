@@ -0,0 +1,30 @@
+;; Repeated lookups with 1 KB string keys: the hash of a string is computed
+;; once and kept in the string, later lookups only compare the keys whose
+;; hash matches
+
+(defun (repeat s n)
+    (let ((res ""))
+      (begin (dotimes (i n) (setq res (+ res s))) res)))
+(setq padding (repeat "x" 1000))
+
+(setq keys (make-hash-table))
+(dotimes (i 1000) (set-hash keys i (+ padding (to-string (+ i 1000)))))
+(setq table (make-hash-table))
+(dotimes (i 1000) (set-hash table (get-hash keys i) i))
+
+(setq found 0)
+(print "look up 1000 keys of 1 KB 1000 times: "
+       (timeit (dotimes (j 1000)
+                 (dotimes (i 1000)
+                   (setq found (get-hash table (get-hash keys i))))))
+       " ms")
+
+(setq pairs (make-hash-table))
+(print "set 1000 list keys of two 1 KB strings 100 times: "
+       (timeit (dotimes (j 100)
+                 (dotimes (i 1000)
+                   (set-hash pairs
+                             (cons (get-hash keys i) (get-hash keys (- 999 i)))
+                             j))))
+       " ms")
+(print "list keys: " (hash-count pairs))
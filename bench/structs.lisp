@@ -0,0 +1,39 @@
+;; Reading and writing the fields of records, as structs and as hash tables
+;; with string keys
+
+(defstruct point x y)
+(setq p (make-point 1 2))
+(setq h (make-hash-table))
+(set-hash h "x" 1)
+(set-hash h "y" 2)
+
+(defun (struct-reads n)
+    (let ((total 0))
+      (begin
+       (dotimes (i n) (setq total (+ total (+ (point-x p) (point-y p)))))
+       total)))
+(defun (hash-reads n)
+    (let ((total 0))
+      (begin
+       (dotimes (i n) (setq total (+ total (+ (get-hash h "x") (get-hash h "y")))))
+       total)))
+(print "struct reads 1000000 iterations: " (timeit (struct-reads 1000000))
+       " ms")
+(print "get-hash reads 1000000 iterations: " (timeit (hash-reads 1000000))
+       " ms")
+
+(defun (struct-writes n) (dotimes (i n) (set-point-x p i)))
+(defun (hash-writes n) (dotimes (i n) (set-hash h "x" i)))
+(print "struct writes 1000000 iterations: " (timeit (struct-writes 1000000))
+       " ms")
+(print "set-hash writes 1000000 iterations: " (timeit (hash-writes 1000000))
+       " ms")
+
+(print "make-point 1000000 iterations: "
+       (timeit (dotimes (i 1000000) (make-point i i))) " ms")
+(print "make-hash-table 1000000 iterations: "
+       (timeit (dotimes (i 1000000)
+                 (setq h (make-hash-table))
+                 (set-hash h "x" i)
+                 (set-hash h "y" i)))
+       " ms")
@@ -0,0 +1,17 @@
+;; Iterative loops written as tail calls, they run in constant stack space
+
+(defun (count-down n)
+    (if (= n 0)
+        nil
+      (count-down (- n 1))))
+
+(defun (ping n)
+    (cond
+     ((= n 0) nil)
+     (else (pong (- n 1)))))
+
+(defun (pong n)
+    (ping n))
+
+(print "count-down 10000000 iterations: " (timeit (count-down 10000000)) " ms")
+(print "ping-pong 10000000 iterations: " (timeit (ping 10000000)) " ms")
@@ -0,0 +1,28 @@
+(defun (greet) "hello")
+(defun (greet-all n)
+    (let ((acc ""))
+      (begin
+       (dotimes (i n) (setq acc (+ acc (greet))))
+       acc)))
+(print "before: " (greet-all 2))
+(defun (greet) "bye")
+(print "redefined: " (greet-all 2))
+(setq greet (lambda () "lambda"))
+(print "setq: " (greet-all 2))
+(defun (op a b) (+ a b))
+(setq results "")
+(dolist (f '((lambda (a b) (- a b)) (lambda (a b) (* a b))))
+  (setq op f)
+  (setq results (+ results (+ " " (to-string (op 6 3))))))
+(print "rebound in a loop: " results)
+(dolist (op '((lambda (a b) (+ a b))))
+  (print "loop variable: " (op 6 3)))
+(defun (op a b) (+ a b))
+(print "after the loop: " (op 6 3))
+(defun (add a b) (+ a b))
+(print "built-in: " (add 1 2))
+(setq old+ +)
+(setq + (lambda (a b) (old+ (old+ a b) 100)))
+(print "rebound built-in: " (add 1 2))
+(setq + old+)
+(print "restored built-in: " (add 1 2))
@@ -0,0 +1,41 @@
+(defun (make-adder n)
+    (lambda (x) (+ x n)))
+
+(setq add5 (make-adder 5))
+(setq add10 (make-adder 10))
+(print (add5 1) " " (add10 1))
+
+(defun (make-counter)
+    (setq count 0)
+    (lambda ()
+      (begin
+        (setq count (+ count 1))
+        count)))
+
+(setq counter (make-counter))
+(counter)
+(print (counter))
+
+(defun (outer a)
+    (defun (middle b)
+        (defun (inner c) (+ a (+ b c)))
+      (inner 3))
+  (middle 2))
+(print (outer 1))
+
+(defun (even-odd n)
+    (defun (is-even k) (if (= k 0) true (is-odd (- k 1))))
+  (defun (is-odd k) (if (= k 0) false (is-even (- k 1))))
+  (is-even n))
+(print (even-odd 10) " " (even-odd 7))
+
+(setq x "global")
+(defun (show-x) x)
+(defun (shadow-x x) (show-x))
+(print (shadow-x "local"))
+
+(let ((y 1))
+  (begin
+    (let ((y 2))
+      (print y))
+    (print y)))
@@ -0,0 +1,32 @@
+(defun (call-this n) (* n 2))
+(print "folded: " (call-this (* 128 16)) " " (+ "con" "cat") " " (not nil))
+(print "if: " (if (< 1 2) "then" "else") " " (if false 1 (- 10 3)))
+(print "cond: " (cond ((= 1 2) "one") ((> 3 2) "two") (else "three")))
+(print "cond else: " (cond (false 1) (else (+ 1 1))))
+(print "cond none: " (cond (false 1) (nil 2)))
+(defun (pair-list) '((+ 1 2) 4 "five"))
+(print "literal: " (pair-list) " " (= (pair-list) (pair-list)))
+(defun (raw . forms) forms)
+(print "variadic: " (raw (+ 1 2) (not true)))
+(defun (shadow not) (not 1))
+(print "parameter: " (shadow (lambda (x) "shadowed")))
+(setq old- -)
+(setq - +)
+(print "rebound: " (- 1 2))
+(setq - old-)
+(print "restored: " (- 1 2))
+(setq old* *)
+(setq results "")
+(dotimes (i 2)
+  (setq results (+ results (to-string (* 3 4))))
+  (setq * +))
+(setq * old*)
+(print "rebound in a loop: " results)
+(defun (three) (+ 1 2))
+(setq old+ +)
+(defun (+ a b) (- a b))
+(print "redefined after the function: " (three))
+(setq + old+)
+(setq old/ /)
+(begin (eval "(setq / *)") (print "rebound by eval: " (/ 8 2)))
+(setq / old/)
@@ -0,0 +1,16 @@
+(defun (sum-to n)
+    (if (= n 0)
+        0
+      (+ n (sum-to (- n 1)))))
+
+(print "Sum: " (sum-to 50000))
+
+(defun (make-list n)
+    (if (= n 0)
+        '()
+      (cons n (make-list (- n 1)))))
+
+(setq items (make-list 2000))
+(print "Length: " (length items))
+(print "Appended: " (length (append items items)))
+(print "Mapped: " (accumulate + (map (lambda (x) (* x 2)) items) 0))
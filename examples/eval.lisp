@@ -9,3 +9,22 @@
             (cons i (iter (+ i 1)))))
     (iter 0))
 (print "This works " (map (lambda (x) (** 2 x)) (natural-numbers 14)))
+(setq evaluated 0)
+(dotimes (i 1000) (setq evaluated (+ evaluated (eval "(+ 1 1)"))))
+(print "Evaluated in a loop: " evaluated)
+(print "Nested: " (eval "(eval \"(* 6 7)\")"))
+(setq x 1)
+(setq seen "")
+(dotimes (i 3)
+  (setq x (+ x 1))
+  (setq seen (+ seen (to-string (eval "'(x)")))))
+(print "Literal lists are evaluated every time: " seen)
+(setq stats (eval-cache-stats))
+(print "Cached: " (get-hash stats "size") ", hits: " (get-hash stats "hits"))
+(defun (double x) (* x 2))
+(print "Before redefining: " (eval "(double 21)"))
+(defun (double x) (+ x (+ x 1)))
+(print "After redefining: " (eval "(double 21)"))
+(print "Folded: " (eval "(* 6 7)"))
+(defun (* a b) (- a b))
+(print "Folded after rebinding: " (eval "(* 6 7)"))
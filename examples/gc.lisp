@@ -0,0 +1,21 @@
+(defun (make-adder n)
+    (lambda (x) (+ x n)))
+
+(setq kept (make-hash-table))
+
+(defun (churn n)
+    (if (= n 0)
+        nil
+      (begin
+       (cons (to-string n) (to-string n) (to-string n))
+       (if (= (remainder n 10000) 0)
+           (set-hash kept n (make-adder n))
+         nil)
+       (churn (- n 1)))))
+
+(churn 300000)
+(print "Collected: " (> (get-hash (gc-stats) "cycles") 0))
+(print "Kept: " ((get-hash kept 10000) 1) " " ((get-hash kept 300000) 1))
+(setq add5 (make-adder 5))
+(churn 300000)
+(print "Still kept: " (add5 1) " " ((get-hash kept 150000) 1))
@@ -0,0 +1,10 @@
+(setq kept (make-hash-table))
+(defun (grow n)
+    (dotimes (i n)
+      (begin
+       (set-hash kept i (cons (to-string i) (to-string i)))
+       (cons i i i i))))
+(grow 200000)
+(setq stats (gc-stats))
+(print "Major cycles done: " (> (get-hash stats "major-cycles") 0))
+(print "Kept: " (hash-count kept) " " (get-hash kept 199999))
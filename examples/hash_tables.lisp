@@ -7,3 +7,39 @@
 (print "Value at key orange in hash table: " (get-hash some-hash-table "orange"))
 (print "Value at key 8 in hash table: " (get-hash some-hash-table 8))
 (print "Resulting hashtable: " some-hash-table)
+(print "Count: " (hash-count some-hash-table))
+(print "Removed orange: " (remove-hash some-hash-table "orange"))
+(print "Removed orange again: " (remove-hash some-hash-table "orange"))
+(print "Value at key orange after removing: " (get-hash some-hash-table "orange"))
+(print "Count after removing: " (hash-count some-hash-table))
+; nil, false and true hash like the numbers 2, 10 and 18
+(setq colliding (make-hash-table))
+(set-hash colliding 2 "two")
+(set-hash colliding nil "nil")
+(set-hash colliding 10 "ten")
+(set-hash colliding false "false")
+(print "Colliding keys: " (get-hash colliding 2) " " (get-hash colliding nil)
+       " " (get-hash colliding 10) " " (get-hash colliding false))
+(setq numbers (make-hash-table))
+(dotimes (i 1000) (set-hash numbers i (* i i)))
+(dotimes (i 500) (remove-hash numbers (* i 2)))
+(print "Odd squares left: " (hash-count numbers) ", 999: "
+       (get-hash numbers 999) ", 998: " (get-hash numbers 998))
+(dotimes (i 500) (set-hash numbers (* i 2) i))
+(print "Refilled: " (hash-count numbers) ", 998: " (get-hash numbers 998))
+(setq composite (make-hash-table))
+(set-hash composite (cons "a" 1) "first")
+(set-hash composite (cons "a" 2) "second")
+(set-hash composite (cons "a" 1) "first again")
+(print "List keys: " (hash-count composite) " " (get-hash composite (cons "a" 1))
+       " " (get-hash composite (cons "a" 2)) " " (get-hash composite (cons "a" 3)))
+(setq name "app")
+(print "Equal strings: " (get-hash some-hash-table (+ name "le")))
+(setq mixed (make-hash-table))
+(set-hash mixed 1 "integer")
+(set-hash mixed 1.0 "float")
+(set-hash mixed (cons 1 2) "integer list")
+(set-hash mixed (cons 1.0 2) "float list")
+(print "Numeric keys: " (hash-count mixed) " " (get-hash mixed 1) " "
+       (get-hash mixed 1.0) " " (get-hash mixed (cons 1 2)) " "
+       (get-hash mixed (cons 1.0 2)))
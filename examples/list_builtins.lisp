@@ -0,0 +1,55 @@
+;; The built-in list library against the versions in stdlib/basic.lisp
+
+(defun (check name native lisp)
+    (print name ": " native (if (= native lisp) "" " MISMATCH ")
+           (if (= native lisp) "" lisp)))
+
+(setq nums '(3 1 4 1 5 9 2 6))
+(setq mixed '("one" 2 "three" 4))
+(setq empty '())
+
+(check "length" (length nums) (lisp-length nums))
+(check "length of mixed" (length mixed) (lisp-length mixed))
+(check "length of empty" (length empty) (lisp-length empty))
+(check "length of nil" (length nil) (lisp-length nil))
+
+(check "append" (append nums '(7 8)) (lisp-append nums '(7 8)))
+(check "append mixed" (append mixed nums) (lisp-append mixed nums))
+(check "append a value" (append nums 10) (lisp-append nums 10))
+(check "append to empty" (append empty nums) (lisp-append empty nums))
+
+(check "reverse" (reverse nums) (lisp-reverse nums))
+(check "reverse mixed" (reverse mixed) (lisp-reverse mixed))
+(check "reverse empty" (reverse empty) (lisp-reverse empty))
+
+(defun (square x) (* x x))
+(check "map" (map square nums) (lisp-map square nums))
+(check "map lambda" (map (lambda (x) (+ x 1)) nums)
+       (lisp-map (lambda (x) (+ x 1)) nums))
+(check "map to lists" (map (lambda (x) (cons x x)) nums)
+       (lisp-map (lambda (x) (cons x x)) nums))
+(check "map built-in" (map to-string nums) (lisp-map to-string nums))
+(check "map empty" (map square empty) (lisp-map square empty))
+
+(check "accumulate" (accumulate + nums 0) (lisp-accumulate + nums 0))
+(check "accumulate order"
+       (accumulate (lambda (acc x) (+ acc (to-string x))) nums "")
+       (lisp-accumulate (lambda (acc x) (+ acc (to-string x))) nums ""))
+(check "accumulate empty" (accumulate + empty 42) (lisp-accumulate + empty 42))
+
+(setq seen (make-hash-table))
+(set-hash seen "native" "")
+(set-hash seen "lisp" "")
+(for-each (lambda (x) (set-hash seen "native" (+ (get-hash seen "native")
+                                                 (to-string x))))
+          nums)
+(lisp-for-each (lambda (x) (set-hash seen "lisp" (+ (get-hash seen "lisp")
+                                                    (to-string x))))
+               nums)
+(check "for-each" (get-hash seen "native") (get-hash seen "lisp"))
+
+(print "nth: " (nth nums 0) " " (nth nums 5) " " (nth nums 8) " " (nth mixed 0))
+(print "last: " (last nums) " " (last mixed) " " (last empty))
+(print "sublist: " (sublist nums 2 5) " " (sublist nums 6) " " (sublist nums 5 2)
+       " " (sublist nums 0 100))
+(print "sublist of sublist: " (sublist (sublist nums 2) 1 3) ", list: " nums)
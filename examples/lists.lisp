@@ -32,3 +32,10 @@
             (cons i (iter (+ i 1)))))
     (iter 0))
 (for-each-except 5 print (natural-numbers 10))
+
+(setq abc-tail (cdr abc))
+(setq extended (cons abc-tail 9))
+(print "Tail: " abc-tail ", extended: " extended ", list: " abc)
+(print "cdr of cdr: " (cdr (cdr list-desc)) " " (cdr (cdr (cdr list-desc))))
+(print "cdr of the empty list: " (cdr '()))
+(print "Tail length: " (length abc-tail) ", equal: " (= abc-tail '(2 1 5 6 7 8)))
@@ -0,0 +1,37 @@
+(setq total 0)
+(dotimes (i 10) (setq total (+ total i)))
+(print "dotimes total: " total)
+(setq i 0)
+(setq acc "")
+(while (< i 5)
+  (setq acc (+ acc (to-string i)))
+  (setq i (+ i 1)))
+(print "while: " acc " " i)
+(dolist (x '(3 4 5)) (print "x: " x))
+(dolist (x nil) (print "never"))
+(dotimes (k 0) (print "never"))
+(defun (sum-list l)
+    (let ((s 0))
+      (begin
+       (dolist (x l) (setq s (+ s x)))
+       s)))
+(print "sum-list: " (sum-list '(1 2 3 4)))
+(defun (make-counters n)
+    (let ((fs '()))
+      (begin
+       (dotimes (j n) (setq fs (cons fs (lambda () j))))
+       fs)))
+(print "counters: " (length (make-counters 3)))
+(setq x "outer")
+(dolist (x '(1 2)) nil)
+(print "x after: " x)
+(print "result: " (dotimes (q 3) q))
+(setq before (objects-allocated))
+(setq n 0)
+(dotimes (k 1000) (setq n (+ n k)))
+(print "n: " n ", objects allocated: " (- (objects-allocated) before))
+(defun (count-to n)
+    (begin
+     (dotimes (i n) (setq reached (+ i 1)))
+     reached))
+(print "bound in the loop body: " (count-to 5))
@@ -0,0 +1,35 @@
+(defun-memo (fib n)
+    (if (< n 2)
+        n
+      (+ (fib (- n 1)) (fib (- n 2)))))
+(print "fib 40: " (fib 40))
+(setq stats (memo-stats fib))
+(print "misses: " (get-hash stats "misses") ", hits: " (get-hash stats "hits"))
+(print "size: " (get-hash stats "size") ", capacity: " (get-hash stats "capacity"))
+(setq counter (make-hash-table))
+(defun (count-call) (set-hash counter "calls" (+ (get-hash counter "calls") 1)))
+(defun (calls) (get-hash counter "calls"))
+(set-hash counter "calls" 0)
+(defun (slow-square x) (begin (count-call) (* x x)))
+(setq square (memoize slow-square 2))
+(print "squares: " (square 3) " " (square 4) " " (square 3) " " (square 5))
+(print "calls: " (calls))
+(print "recomputed after eviction: " (square 4) ", calls: " (calls))
+(print "evictions: " (get-hash (memo-stats square) "evictions"))
+(set-memo-capacity square 1)
+(print "size after shrinking: " (get-hash (memo-stats square) "size"))
+(defun (describe x) (begin (count-call) (to-string x)))
+(setq describe-memo (memoize describe))
+(set-hash counter "calls" 0)
+(describe-memo '(1 2 3))
+(describe-memo '(1 2 3))
+(describe-memo '("a" 2))
+(describe-memo 7)
+(describe-memo "apple")
+(print "calls for lists, numbers and strings: " (calls))
+(describe-memo (make-hash-table))
+(describe-memo (make-hash-table))
+(print "hash tables aren't cached, calls: " (calls))
+(print "fib is " fib)
+(defun-memo (half x) (/ x 2))
+(print "half of 3.0: " (half 3.0) ", half of 3: " (half 3))
@@ -0,0 +1,41 @@
+(setq v (list->i64vector '(3 1 4 1 5 9 2 6)))
+(print "Vector: " v ", length: " (vec-length v))
+(print "Sum: " (vec-sum v) ", min: " (vec-min v) ", max: " (vec-max v))
+(print "Third: " (vec-ref v 2) ", set: " (vec-set v 2 40) " " v)
+(print "Prefix sums: " (vec-prefix-sum v))
+(print "Scaled: " (vec-scale v 3))
+(print "As a list: " (vec->list v))
+(setq ones (make-i64vector 8 1))
+(print "Added: " (vec-add v ones))
+(print "Multiplied: " (vec-mul v v))
+(print "Dot: " (vec-dot v ones) " " (vec-dot v v))
+(setq big (make-i64vector 37))
+(dotimes (i 37) (vec-set big i (- (* i 7) 100)))
+(print "Big sum: " (vec-sum big) ", min: " (vec-min big) ", max: "
+       (vec-max big))
+(print "Big dot: " (vec-dot big big))
+(print "Big prefix end: " (vec-ref (vec-prefix-sum big) 36))
+(print "Big product end: " (vec-ref (vec-mul big (vec-scale big 2)) 36))
+(setq f (list->f64vector '(2 4 6 8 10 12 14 16 18)))
+(print "Doubles: " f)
+(print "Doubles sum: " (vec-sum f) ", min: " (vec-min f) ", max: " (vec-max f))
+(print "Doubles dot: " (vec-dot f f) ", prefix: " (vec-prefix-sum f))
+(print "Doubles added: " (vec-add f (vec-scale f 2)))
+(print "Empty: " (make-f64vector 0) " " (vec-min (make-i64vector 0)))
+(if (make-i64vector 0) (print "Empty is true") (print "Empty is false"))
+(setq big (make-i64vector 1000000 1))
+(setq stats (heap-stats))
+(print "Elements outside the pages: " (> (get-hash stats "external-bytes") 7999999)
+       ", fragmentation in range: " (< (get-hash stats "fragmentation") 101))
+(setq max 4611686018427387903)
+(setq min -4611686018427387904)
+(setq at-max (make-i64vector 9 max))
+(setq at-min (make-i64vector 9 min))
+(print "Sum past the i64s: " (vec-sum at-max) " " (vec-sum at-min))
+(print "Dot past the i64s: " (vec-dot at-max at-max) " " (vec-dot at-min at-min))
+(print "Smallest i64 sum: " (vec-sum (make-i64vector 2 min)))
+(print "Back in range: " (vec-sum (list->i64vector '(4611686018427387903 4611686018427387903 -4611686018427387904 -4611686018427387904 5))))
+(print "Widest squares: " (vec-ref (vec-scale (make-i64vector 9 2147483647) 2147483647) 8)
+       " " (vec-ref (vec-mul at-max (make-i64vector 9 1)) 8)
+       " " (vec-ref (vec-add at-max (make-i64vector 9 min)) 8)
+       " " (vec-ref (vec-prefix-sum (list->i64vector '(4611686018427387903 -1 1))) 2))
@@ -0,0 +1,37 @@
+(print "Largest fixnum: " (- (** 2 62) 1) ", plus one: " (+ (- (** 2 62) 1) 1))
+(print "Smallest fixnum: " (- 0 (** 2 62)) ", minus one: "
+       (- (- 0 (** 2 62)) 1))
+(print "Back to a fixnum: " (- (** 2 62) 1) " " (- (+ (** 2 62) 5) (** 2 62)))
+(print "2^100: " (** 2 100) ", (-3)^41: " (** -3 41))
+(print "Literal: " 123456789012345678901234567890 " " -98765432109876543210)
+(defun (factorial n)
+    (let ((res 1))
+      (begin
+       (dotimes (i n) (setq res (* res (+ i 1))))
+       res)))
+(print "30! = " (factorial 30))
+(print "30! / 28! = " (/ (factorial 30) (factorial 28)))
+(print "30! remainder 2^61: " (remainder (factorial 30) (** 2 61)))
+(print "Truncated division: " (/ -7 2) " " (remainder -7 2) " "
+       (/ (- 0 (** 10 25)) 3) " " (remainder (- 0 (** 10 25)) 3))
+(defun (fib-iter n)
+    (let ((a 0) (b 1) (next 0))
+      (begin
+       (dotimes (i n)
+         (begin (setq next (+ a b)) (setq a b) (setq b next)))
+       a)))
+(print "Fibonacci of 100 is " (fib-iter 100))
+(print "Floats: " 1.5 " " -2.25 " " 1e3 " " 2.5e-3 " " (/ 1 4.0) " " (* 3 0.5))
+(print "Mixed: " (+ 1 0.5) " " (- (** 2 70) 0.5) " " (/ 7 2) " " (/ 7 2.0))
+(print "Float remainder: " (remainder 7.5 2) ", powers: " (** 2 -2) " "
+       (** 9.0 0.5))
+(print "Comparisons: " (= 2 2.0) " " (< 1 1.5) " " (> (** 2 80) 1e24) " "
+       (= (** 2 80) (** 2.0 80)) " " (< (- 0 (** 2 80)) -1e10))
+(setq table (make-hash-table))
+(set-hash table (** 2 80) "2^80")
+(set-hash table 3 "three")
+(print "Hashed: " (get-hash table (** 2 80)) " " (get-hash table 3)
+       ", as floats: " (get-hash table (** 2.0 80)) " " (get-hash table 3.0))
+(setq f 0.0)
+(dotimes (i 200000) (setq f (+ f 0.5)))
+(print "Floats collected: " f)
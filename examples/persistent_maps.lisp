@@ -0,0 +1,45 @@
+(setq empty (make-persistent-map))
+(setq fruits (assoc (assoc (assoc empty "apple" 3) "pear" 5) "plum" 7))
+(print "Empty map: " empty ", count: " (map-count empty))
+(print "Apples: " (lookup fruits "apple") ", figs: " (lookup fruits "fig"))
+(print "Count: " (map-count fruits) ", map: " fruits)
+(setq more-fruits (assoc fruits "apple" 4))
+(print "Apples in the new version: " (lookup more-fruits "apple")
+       ", in the old one: " (lookup fruits "apple"))
+(setq fewer-fruits (dissoc fruits "pear"))
+(print "Pears after dissoc: " (lookup fewer-fruits "pear") ", count: "
+       (map-count fewer-fruits) ", before: " (lookup fruits "pear")
+       ", count: " (map-count fruits))
+(print "Dissoc of a missing key: " (map-count (dissoc fruits "fig")))
+(print "Single entry: " (assoc empty 1 "one"))
+(if empty (print "Empty maps are truthy") (print "Empty maps are falsy"))
+; nil, false and true hash like the numbers 2, 10 and 18
+(setq colliding (assoc (assoc (assoc empty 2 "two") nil "nil") 10 "ten"))
+(setq colliding (assoc colliding false "false"))
+(print "Colliding keys: " (lookup colliding 2) " " (lookup colliding nil)
+       " " (lookup colliding 10) " " (lookup colliding false))
+(setq colliding (dissoc colliding nil))
+(print "Without nil: " (map-count colliding) " " (lookup colliding 2) " "
+       (lookup colliding nil) " " (lookup colliding false))
+(setq numbers empty)
+(dotimes (i 5000) (setq numbers (assoc numbers i (* i i))))
+(setq half numbers)
+(dotimes (i 2500) (setq half (dissoc half (* i 2))))
+(print "Squares: " (map-count numbers) ", 4998: " (lookup numbers 4998)
+       ", odd ones: " (map-count half) ", 4998: " (lookup half 4998)
+       ", 4999: " (lookup half 4999))
+(dotimes (i 2500) (setq half (dissoc half (+ (* i 2) 1))))
+(print "Emptied: " (map-count half) " " half)
+(setq table (make-hash-table))
+(set-hash table "a" 1)
+(set-hash table "b" 2)
+(setq from-table (hash-table->map table))
+(set-hash table "c" 3)
+(print "From a hash table: " (map-count from-table) " " (lookup from-table "b")
+       " " (lookup from-table "c"))
+(setq back (map->hash-table (assoc from-table "d" 4)))
+(print "Back to a hash table: " (hash-count back) " " (get-hash back "d"))
+(setq composite (assoc empty (cons "a" 1) "first"))
+(setq composite (assoc composite (cons "a" 2) "second"))
+(print "List keys: " (lookup composite (cons "a" 1)) " "
+       (lookup composite (cons "a" 2)) " " (lookup composite (cons "a" 3)))
@@ -0,0 +1,35 @@
+(defstruct point x y)
+(setq p (make-point 3 4))
+(print "Point: " p)
+(print "x: " (point-x p) ", y: " (point-y p))
+(print "Setting x: " (set-point-x p 10) ", x: " (point-x p))
+(print "point? " (point? p) " " (point? 5) " " (point? (make-hash-table)))
+(defstruct segment from to)
+(setq s (make-segment (make-point 0 0) p))
+(print "Segment: " s)
+(print "Segment end x: " (point-x (segment-to s)))
+(print "Segment? " (segment? s) ", point? " (point? s))
+(defun (squared-length seg)
+    (let ((dx (- (point-x (segment-to seg)) (point-x (segment-from seg))))
+          (dy (- (point-y (segment-to seg)) (point-y (segment-from seg)))))
+      (+ (* dx dx) (* dy dy))))
+(print "Squared length: " (squared-length s))
+(defun (move-by pt dx)
+    (set-point-x pt (+ (point-x pt) dx)))
+(dotimes (i 5) (move-by p i))
+(print "Moved: " (point-x p))
+(setq points (map (lambda (n) (make-point n (* n n))) '(1 2 3)))
+(print "Mapped: " (map point-y points))
+(defstruct empty)
+(print "Empty: " (make-empty) " " (empty? (make-empty)))
+(setq accessor point-y)
+(print "Accessor as a value: " (accessor p) " " accessor)
+(if (= point-x point-y) (print "Accessors are equal") (print "Accessors differ"))
+(setq junk nil)
+(dotimes (i 200000) (setq junk (cons (to-string i) "a")))
+(setq junk nil)
+(defstruct pt x y)
+(defstruct wide a b c d e f g)
+(dotimes (i 400000) (setq junk (cons (to-string i) "a")))
+(print "Collected after defstruct: " (pt-x (make-pt 1 2)) " "
+       (wide-g (make-wide 1 2 3 4 5 6 7)))
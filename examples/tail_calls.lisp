@@ -0,0 +1,41 @@
+(defun (count-down n)
+    (if (= n 0)
+        "done"
+      (count-down (- n 1))))
+
+(print "Counted down: " (count-down 100000))
+
+(defun (even? n)
+    (cond
+     ((= n 0) true)
+     (else (odd? (- n 1)))))
+
+(defun (odd? n)
+    (cond
+     ((= n 0) false)
+     (else (even? (- n 1)))))
+
+(print "Even: " (even? 10001) ", odd: " (odd? 10001))
+
+(defun (sum-to n acc)
+    (let ((next (- n 1)))
+      (if (< n 1)
+          acc
+        (begin
+          (sum-to next (+ acc n))))))
+
+(print "Sum: " (sum-to 10000 0))
+
+(defun (make-list n acc)
+    (if (= n 0)
+        acc
+      (make-list (- n 1) (cons n acc))))
+
+(setq items (make-list 1000 '()))
+(print "Length: " (length items))
+
+(setq visited (make-hash-table))
+(set-hash visited "count" 0)
+(for-each (lambda (x) (set-hash visited "count" (+ (get-hash visited "count") 1)))
+          items)
+(print "Visited: " (get-hash visited "count"))
@@ -0,0 +1,32 @@
+#!/usr/bin/env bash
+# Runs lisp files with both the bytecode VM and the tree-walking evaluator,
+# compares their output and reports the running times.
+# Usage: ./scripts/compare-evaluators.sh [files...]
+
+SCRIPT_DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" &> /dev/null && pwd )"
+ROOT_DIR="$SCRIPT_DIR/.."
+INTERP="${QLISP:-$ROOT_DIR/Release/qlisp}"
+
+if [ $# -eq 0 ]; then
+  set -- "$ROOT_DIR/examples/recursion.lisp" "$ROOT_DIR/examples/fib.lisp"
+fi
+
+cd "$ROOT_DIR"
+status=0
+for f in "$@"; do
+  vm_start=$(date +%s%N)
+  vm_out=$("$INTERP" "$f" 2>&1 < /dev/null)
+  vm_end=$(date +%s%N)
+  tw_out=$("$INTERP" --tree-walk "$f" 2>&1 < /dev/null)
+  tw_end=$(date +%s%N)
+  vm_ms=$(( (vm_end - vm_start) / 1000000 ))
+  tw_ms=$(( (tw_end - vm_end) / 1000000 ))
+  if [ "$vm_out" == "$tw_out" ]; then
+    echo "$f: same output, vm ${vm_ms} ms, tree-walk ${tw_ms} ms"
+  else
+    echo "$f: output differs, vm ${vm_ms} ms, tree-walk ${tw_ms} ms"
+    diff <(echo "$vm_out") <(echo "$tw_out")
+    status=1
+  fi
+done
+exit $status
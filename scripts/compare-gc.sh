@@ -0,0 +1,20 @@
+#!/usr/bin/env bash
+# Runs lisp files with the generational collector and with full collections
+# only (--gc-full) and prints what they report.
+# Usage: ./scripts/compare-gc.sh [files...]
+
+SCRIPT_DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" &> /dev/null && pwd )"
+ROOT_DIR="$SCRIPT_DIR/.."
+INTERP="${QLISP:-$ROOT_DIR/Release/qlisp}"
+
+if [ $# -eq 0 ]; then
+  set -- "$ROOT_DIR/bench/gc-generations.lisp"
+fi
+
+cd "$ROOT_DIR"
+for f in "$@"; do
+  echo "== $f: generational"
+  "$INTERP" "$f" < /dev/null
+  echo "== $f: full collections only"
+  "$INTERP" --gc-full "$f" < /dev/null
+done
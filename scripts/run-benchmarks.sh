@@ -0,0 +1,23 @@
+#!/usr/bin/env bash
+# Runs the benchmarks in bench/ and reports the time per iteration for the
+# "<name> <n> iterations: <ms> ms" lines they print.
+# Usage: ./scripts/run-benchmarks.sh [files...]
+
+SCRIPT_DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" &> /dev/null && pwd )"
+ROOT_DIR="$SCRIPT_DIR/.."
+INTERP="${QLISP:-$ROOT_DIR/Release/qlisp}"
+
+if [ $# -eq 0 ]; then
+  set -- "$ROOT_DIR"/bench/*.lisp
+fi
+
+cd "$ROOT_DIR"
+for f in "$@"; do
+  echo "== $f"
+  "$INTERP" "$f" < /dev/null | awk '
+    / iterations: [0-9.]+ ms$/ {
+      printf "%s (%.1f ns/iteration)\n", $0, $(NF - 1) * 1000000 / $2
+      next
+    }
+    { print }'
+done
@@ -0,0 +1,331 @@
+#include "bignum.hpp"
+
+#include <math.h>
+
+#include <algorithm>
+
+void trim(Limbs &a) {
+  while (!a.empty() && a.back() == 0) a.pop_back();
+}
+
+LimbSpan limbs_significant(LimbSpan a) {
+  size_t n = a.size();
+  while (n > 0 && a[n - 1] == 0) --n;
+  return a.first(n);
+}
+
+int limbs_cmp(LimbSpan a, LimbSpan b) {
+  a = limbs_significant(a);
+  b = limbs_significant(b);
+  if (a.size() != b.size()) return a.size() < b.size() ? -1 : 1;
+  for (size_t i = a.size(); i-- > 0;) {
+    if (a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
+  }
+  return 0;
+}
+
+Limbs limbs_add(LimbSpan a, LimbSpan b) {
+  if (a.size() < b.size()) std::swap(a, b);
+  Limbs res(a.size() + 1);
+  u64 carry = 0;
+  size_t i = 0;
+  for (; i < b.size(); ++i) {
+    carry += (u64)a[i] + b[i];
+    res[i] = (u32)carry;
+    carry >>= 32;
+  }
+  for (; i < a.size(); ++i) {
+    carry += a[i];
+    res[i] = (u32)carry;
+    carry >>= 32;
+  }
+  res[a.size()] = (u32)carry;
+  trim(res);
+  return res;
+}
+
+// a -= b in place, a must not be less than b
+void sub_into(u32 *a, size_t na, LimbSpan b) {
+  u64 borrow = 0;
+  for (size_t i = 0; i < na && (i < b.size() || borrow != 0); ++i) {
+    u64 d = (u64)a[i] - (i < b.size() ? b[i] : 0) - borrow;
+    a[i] = (u32)d;
+    borrow = (d >> 32) != 0;
+  }
+}
+
+// a += b in place, the sum must fit in the na limbs
+void add_into(u32 *a, size_t na, LimbSpan b) {
+  u64 carry = 0;
+  for (size_t i = 0; i < na && (i < b.size() || carry != 0); ++i) {
+    carry += (u64)a[i] + (i < b.size() ? b[i] : 0);
+    a[i] = (u32)carry;
+    carry >>= 32;
+  }
+}
+
+Limbs limbs_sub(LimbSpan a, LimbSpan b) {
+  Limbs res(a.begin(), a.end());
+  sub_into(res.data(), res.size(), b);
+  trim(res);
+  return res;
+}
+
+// out[0, na + nb) = a * b, out must be zeroed
+void mul_schoolbook(LimbSpan a, LimbSpan b, u32 *out) {
+  for (size_t i = 0; i < a.size(); ++i) {
+    u64 ai = a[i];
+    if (ai == 0) continue;
+    u64 carry = 0;
+    for (size_t j = 0; j < b.size(); ++j) {
+      carry += ai * b[j] + out[i + j];
+      out[i + j] = (u32)carry;
+      carry >>= 32;
+    }
+    out[i + b.size()] = (u32)carry;
+  }
+}
+
+// out[0, na + nb) = a * b, out must be zeroed
+void mul_into(LimbSpan a, LimbSpan b, u32 *out) {
+  if (a.size() < b.size()) std::swap(a, b);
+  size_t na = a.size();
+  size_t nb = b.size();
+  if (nb < KARATSUBA_THRESHOLD) {
+    // the inner loop over the longer one
+    mul_schoolbook(b, a, out);
+    return;
+  }
+  if (na >= 2 * nb) {
+    // multiplies b by every nb-limb chunk of a, which splits evenly
+    Limbs part(2 * nb);
+    for (size_t i = 0; i < na; i += nb) {
+      auto chunk = a.subspan(i, std::min(nb, na - i));
+      std::fill(part.begin(), part.end(), 0);
+      mul_into(chunk, b, part.data());
+      add_into(out + i, na + nb - i, {part.data(), chunk.size() + nb});
+    }
+    return;
+  }
+  // a = a1 * B^m + a0 and b = b1 * B^m + b0, with b1 not empty since
+  // nb > na / 2: a * b = z2 * B^2m + z1 * B^m + z0 with z0 = a0 * b0,
+  // z2 = a1 * b1 and z1 = (a0 + a1) * (b0 + b1) - z0 - z2
+  size_t m = na / 2;
+  auto a0 = a.first(m), a1 = a.subspan(m);
+  auto b0 = b.first(m), b1 = b.subspan(m);
+  // z0 and z2 go straight to their places in out, they don't overlap
+  mul_into(a0, b0, out);
+  mul_into(a1, b1, out + 2 * m);
+  auto z0 = limbs_significant({out, 2 * m});
+  auto z2 = limbs_significant({out + 2 * m, na + nb - 2 * m});
+  auto sum_a = limbs_add(a0, a1);
+  auto sum_b = limbs_add(b0, b1);
+  Limbs z1(sum_a.size() + sum_b.size());
+  mul_into(sum_a, sum_b, z1.data());
+  sub_into(z1.data(), z1.size(), z0);
+  sub_into(z1.data(), z1.size(), z2);
+  add_into(out + m, na + nb - m, limbs_significant(z1));
+}
+
+Limbs limbs_mul(LimbSpan a, LimbSpan b) {
+  a = limbs_significant(a);
+  b = limbs_significant(b);
+  Limbs res(a.size() + b.size());
+  mul_into(a, b, res.data());
+  trim(res);
+  return res;
+}
+
+// a = a * mul + add in place
+void mul_small_add(Limbs &a, u32 mul, u32 add) {
+  u64 carry = add;
+  for (auto &limb : a) {
+    carry += (u64)limb * mul;
+    limb = (u32)carry;
+    carry >>= 32;
+  }
+  if (carry != 0) a.push_back((u32)carry);
+}
+
+// a /= d in place, returns the remainder
+u32 divmod_small(Limbs &a, u32 d) {
+  u64 rem = 0;
+  for (size_t i = a.size(); i-- > 0;) {
+    u64 cur = (rem << 32) | a[i];
+    a[i] = (u32)(cur / d);
+    rem = cur % d;
+  }
+  trim(a);
+  return (u32)rem;
+}
+
+// Knuth's algorithm D (TAOCP 4.3.1): long division by digits of 32 bits,
+// with the divisor shifted so that its top bit is set to keep the
+// estimates of the quotient digits at most 2 off
+void limbs_divmod(LimbSpan a, LimbSpan b, Limbs &quot, Limbs &rem) {
+  a = limbs_significant(a);
+  b = limbs_significant(b);
+  if (limbs_cmp(a, b) < 0) {
+    quot.clear();
+    rem.assign(a.begin(), a.end());
+    return;
+  }
+  if (b.size() == 1) {
+    quot.assign(a.begin(), a.end());
+    u32 r = divmod_small(quot, b[0]);
+    rem.clear();
+    if (r != 0) rem.push_back(r);
+    return;
+  }
+  int shift = __builtin_clz(b.back());
+  size_t n = b.size();
+  size_t m = a.size() - n;
+  Limbs v(n);
+  Limbs u(a.size() + 1);
+  for (size_t i = n; i-- > 0;) {
+    v[i] = b[i] << shift;
+    if (shift != 0 && i > 0) v[i] |= b[i - 1] >> (32 - shift);
+  }
+  u[a.size()] = shift != 0 ? a.back() >> (32 - shift) : 0;
+  for (size_t i = a.size(); i-- > 0;) {
+    u[i] = a[i] << shift;
+    if (shift != 0 && i > 0) u[i] |= a[i - 1] >> (32 - shift);
+  }
+  quot.assign(m + 1, 0);
+  const u64 base = 1ull << 32;
+  for (size_t j = m + 1; j-- > 0;) {
+    u64 num = ((u64)u[j + n] << 32) | u[j + n - 1];
+    u64 qhat = num / v[n - 1];
+    u64 rhat = num % v[n - 1];
+    while (qhat >= base || qhat * v[n - 2] > ((rhat << 32) | u[j + n - 2])) {
+      --qhat;
+      rhat += v[n - 1];
+      if (rhat >= base) break;
+    }
+    // u[j, j + n] -= qhat * v
+    i64 borrow = 0;
+    u64 carry = 0;
+    for (size_t i = 0; i < n; ++i) {
+      u64 p = qhat * v[i] + carry;
+      carry = p >> 32;
+      i64 t = (i64)u[i + j] - borrow - (i64)(p & 0xFFFFFFFF);
+      u[i + j] = (u32)t;
+      borrow = t < 0;
+    }
+    i64 t = (i64)u[j + n] - borrow - (i64)carry;
+    u[j + n] = (u32)t;
+    if (t < 0) {
+      // qhat was one too many, add v back
+      --qhat;
+      u64 c = 0;
+      for (size_t i = 0; i < n; ++i) {
+        c += (u64)u[i + j] + v[i];
+        u[i + j] = (u32)c;
+        c >>= 32;
+      }
+      u[j + n] += (u32)c;
+    }
+    quot[j] = (u32)qhat;
+  }
+  trim(quot);
+  rem.assign(n, 0);
+  for (size_t i = 0; i < n; ++i) {
+    rem[i] = u[i] >> shift;
+    if (shift != 0) rem[i] |= u[i + 1] << (32 - shift);
+  }
+  trim(rem);
+}
+
+Limbs limbs_from_u64(u64 v) {
+  Limbs res;
+  while (v != 0) {
+    res.push_back((u32)v);
+    v >>= 32;
+  }
+  return res;
+}
+
+Limbs limbs_from_double(double v) {
+  int exp;
+  double frac = frexp(fabs(v), &exp);
+  // v = mantissa * 2^(exp - 53), with the 53 bits of the mantissa
+  u64 mantissa = (u64)ldexp(frac, 53);
+  exp -= 53;
+  if (exp <= -64) return {};
+  if (exp <= 0) return limbs_from_u64(mantissa >> -exp);
+  auto res = limbs_from_u64(mantissa);
+  res.insert(res.begin(), exp / 32, 0);
+  if (exp % 32 != 0) {
+    u32 bits = exp % 32;
+    u32 carry = 0;
+    for (auto &limb : res) {
+      u32 next = limb >> (32 - bits);
+      limb = (limb << bits) | carry;
+      carry = next;
+    }
+    if (carry != 0) res.push_back(carry);
+  }
+  return res;
+}
+
+double limbs_to_double(LimbSpan a) {
+  a = limbs_significant(a);
+  if (a.size() <= 2) return (double)((a.size() > 1 ? (u64)a[1] << 32 : 0) |
+                                     (a.empty() ? 0 : a[0]));
+  // the top 64 bits, with the lowest one set if any bit below them is:
+  // converting that rounds the same as converting the whole number
+  size_t top = a.size() * 32 - __builtin_clz(a.back());
+  size_t shift = top - 64;
+  size_t i = shift / 32;
+  u32 bit = shift % 32;
+  u64 low = a[i] | (u64)a[i + 1] << 32;
+  u64 high = i + 2 < a.size() ? a[i + 2] : 0;
+  u64 head = (low >> bit) | (bit != 0 ? high << (64 - bit) : 0);
+  bool sticky = (a[i] & ((1u << bit) - 1)) != 0;
+  for (size_t k = 0; k < i && !sticky; ++k) sticky = a[k] != 0;
+  return ldexp((double)(head | sticky), (int)shift);
+}
+
+bool limbs_fit_double(LimbSpan a) {
+  a = limbs_significant(a);
+  if (a.empty()) return true;
+  size_t top = a.size() * 32 - __builtin_clz(a.back());
+  size_t low = 0;
+  while (a[low / 32] == 0) low += 32;
+  low += __builtin_ctz(a[low / 32]);
+  return top - low <= 53 && top <= 1024;
+}
+
+Limbs limbs_from_decimal(std::string_view digits) {
+  Limbs res;
+  // 9 digits at a time, the most that fit in a limb
+  size_t first = digits.size() % 9 == 0 ? 9 : digits.size() % 9;
+  for (size_t i = 0; i < digits.size();) {
+    size_t len = i == 0 ? first : 9;
+    u32 chunk = 0;
+    u32 scale = 1;
+    for (size_t k = 0; k < len; ++k) {
+      chunk = chunk * 10 + (digits[i + k] - '0');
+      scale *= 10;
+    }
+    mul_small_add(res, scale, chunk);
+    i += len;
+  }
+  trim(res);
+  return res;
+}
+
+std::string limbs_to_decimal(LimbSpan a) {
+  Limbs rest(a.begin(), a.end());
+  trim(rest);
+  if (rest.empty()) return "0";
+  std::vector<u32> chunks;
+  while (!rest.empty()) chunks.push_back(divmod_small(rest, 1000000000));
+  std::string res = std::to_string(chunks.back());
+  char buf[16];
+  for (size_t i = chunks.size() - 1; i-- > 0;) {
+    snprintf(buf, sizeof(buf), "%09u", chunks[i]);
+    res += buf;
+  }
+  return res;
+}
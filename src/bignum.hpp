@@ -0,0 +1,43 @@
+#ifndef BIGNUM_HPP
+#define BIGNUM_HPP
+
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "types.hpp"
+
+// Magnitudes of the arbitrary-precision integers: base 2^32 digits, least
+// significant first. The results never have leading zero limbs, so zero is
+// empty; the arguments may have them.
+using Limbs = std::vector<u32>;
+using LimbSpan = std::span<u32 const>;
+
+// Products of operands with at least this many limbs are split in three
+// half-size products (Karatsuba) instead of multiplying every pair of limbs
+const size_t KARATSUBA_THRESHOLD = 40;
+
+// The span without its leading zero limbs
+LimbSpan limbs_significant(LimbSpan a);
+// -1, 0 or 1 as a is less than, equal to or greater than b
+int limbs_cmp(LimbSpan a, LimbSpan b);
+Limbs limbs_add(LimbSpan a, LimbSpan b);
+// a - b, a must not be less than b
+Limbs limbs_sub(LimbSpan a, LimbSpan b);
+Limbs limbs_mul(LimbSpan a, LimbSpan b);
+// Truncated division, b must not be zero
+void limbs_divmod(LimbSpan a, LimbSpan b, Limbs &quot, Limbs &rem);
+
+Limbs limbs_from_u64(u64 v);
+// Of an integral double, without its sign
+Limbs limbs_from_double(double v);
+// Rounded to the nearest double, exact when there's one
+double limbs_to_double(LimbSpan a);
+// Whether limbs_to_double is exact
+bool limbs_fit_double(LimbSpan a);
+// Of a string of decimal digits
+Limbs limbs_from_decimal(std::string_view digits);
+std::string limbs_to_decimal(LimbSpan a);
+
+#endif
@@ -0,0 +1,565 @@
+#include "compiler.hpp"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "errors.hpp"
+#include "gc.hpp"
+#include "interpreter.hpp"
+#include "memo.hpp"
+#include "objects.hpp"
+#include "structs.hpp"
+
+char const *proto_name(Proto const *proto) { return proto->name; }
+
+void retain_proto(Proto *proto) { ++proto->refs; }
+
+void release_proto(Proto *proto) {
+  if (--proto->refs > 0) return;
+  for (auto *inner : proto->chunk.protos) release_proto(inner);
+  delete proto;
+}
+
+// Compiles one function (or top-level form); the chain of compilers follows
+// the lexical nesting of the functions
+struct Compiler {
+  Proto *proto;
+  Compiler *parent = nullptr;
+  // Names visible in the function body, innermost last. Let bodies drop
+  // theirs when done.
+  std::vector<std::pair<SymbolId, u32>> names;
+  // top-level code binds unknown names globally instead of locally
+  bool toplevel = false;
+  // number of stack slots in use at the current instruction
+  u32 depth = 0;
+};
+
+enum class VarKind { Global, Local, Env };
+
+struct VarRef {
+  VarKind kind;
+  // environments to go up through, for VarKind::Env
+  u32 depth;
+  // frame slot, or symbol id for globals
+  u32 slot;
+};
+
+inline void adjust_depth(Compiler &c, int effect) {
+  c.depth += effect;
+  if (c.depth > c.proto->chunk.max_stack) {
+    c.proto->chunk.max_stack = c.depth;
+  }
+}
+
+inline u32 emit(Compiler &c, Op op, u32 arg = 0, int effect = 0) {
+  auto &code = c.proto->chunk.code;
+  assert_stmt(arg < (1 << 24), "Instruction argument is too big");
+  code.push_back((u32)op | (arg << 8));
+  adjust_depth(c, effect);
+  return code.size() - 1;
+}
+
+inline u32 emit_word(Compiler &c, u32 word) {
+  auto &code = c.proto->chunk.code;
+  code.push_back(word);
+  return code.size() - 1;
+}
+
+inline u32 here(Compiler &c) { return c.proto->chunk.code.size(); }
+
+inline void patch_arg(Compiler &c, u32 at, u32 arg) {
+  auto &code = c.proto->chunk.code;
+  code[at] = (code[at] & 0xFF) | (arg << 8);
+}
+
+inline void patch_word(Compiler &c, u32 at, u32 word) {
+  c.proto->chunk.code[at] = word;
+}
+
+inline u32 add_const(Compiler &c, Object *obj) {
+  auto &consts = c.proto->chunk.consts;
+  gc_const_barrier(obj);
+  consts.push_back(obj);
+  return consts.size() - 1;
+}
+
+inline bool is_symbol(Object *obj, SymbolId id) {
+  return obj_type(obj) == ObjType::Symbol && sym_id(obj) == id;
+}
+
+// Objects that evaluate to themselves
+inline bool is_self_evaluating(Object *obj) {
+  if (obj_flags(obj) & OF_EVALUATED) return true;
+  return obj_type(obj) != ObjType::Symbol && obj_type(obj) != ObjType::List;
+}
+
+// Returns the special form object if the head of a form names one
+Object *special_form_of(Object *head) {
+  if (obj_type(head) != ObjType::Symbol) return nullptr;
+  auto *val = get_global(sym_id(head));
+  if (obj_type(val) == ObjType::Function && (obj_flags(val) & OF_SPECIAL)) return val;
+  return nullptr;
+}
+
+inline VarRef slot_ref(Compiler &c, u32 slot) {
+  if (c.proto->owns_env) return {VarKind::Env, 0, slot};
+  return {VarKind::Local, 0, slot};
+}
+
+// Finds the lexical address of a variable. Every function that has inner
+// functions owns an environment, so a variable d functions up is found d
+// environments up, or d - 1 from a function without an environment of its
+// own (its current environment is the one it was created in).
+VarRef resolve(Compiler &c, SymbolId id) {
+  u32 distance = 0;
+  for (Compiler *fc = &c; fc != nullptr; fc = fc->parent, ++distance) {
+    for (auto it = fc->names.rbegin(); it != fc->names.rend(); ++it) {
+      if (it->first != id) continue;
+      if (distance == 0) return slot_ref(c, it->second);
+      u32 depth = c.proto->owns_env ? distance : distance - 1;
+      assert_stmt(depth < (1 << 8) && it->second < (1 << 16),
+                  "Too many nested functions or local variables");
+      return {VarKind::Env, depth, it->second};
+    }
+  }
+  return {VarKind::Global, 0, id};
+}
+
+u32 declare_local(Compiler &c, SymbolId id) {
+  u32 slot = c.proto->nslots++;
+  c.names.push_back({id, slot});
+  return slot;
+}
+
+// Binds a name in the innermost scope: a variable of the current function,
+// or a global at top level
+VarRef resolve_binding(Compiler &c, SymbolId id) {
+  for (auto it = c.names.rbegin(); it != c.names.rend(); ++it) {
+    if (it->first == id) return slot_ref(c, it->second);
+  }
+  if (c.toplevel) return {VarKind::Global, 0, id};
+  return slot_ref(c, declare_local(c, id));
+}
+
+void emit_load(Compiler &c, VarRef ref) {
+  switch (ref.kind) {
+    case VarKind::Global: emit(c, Op::LoadGlobal, ref.slot, 1); break;
+    case VarKind::Local: emit(c, Op::LoadLocal, ref.slot, 1); break;
+    case VarKind::Env:
+      emit(c, Op::LoadEnv, (ref.depth << 16) | ref.slot, 1);
+      break;
+  }
+}
+
+void emit_store(Compiler &c, VarRef ref) {
+  switch (ref.kind) {
+    case VarKind::Global: emit(c, Op::StoreGlobal, ref.slot, -1); break;
+    case VarKind::Local: emit(c, Op::StoreLocal, ref.slot, -1); break;
+    case VarKind::Env:
+      emit(c, Op::StoreEnv, (ref.depth << 16) | ref.slot, -1);
+      break;
+  }
+}
+
+// Whether the code can create functions, conservatively
+bool defines_functions(Object *expr) {
+  static SymbolId lambda_sym = intern("lambda");
+  static SymbolId defun_sym = intern("defun");
+  static SymbolId defun_memo_sym = intern("defun-memo");
+  if (!is_list(expr)) return false;
+  for (auto *item : list_members(expr)) {
+    if (is_symbol(item, lambda_sym) || is_symbol(item, defun_sym) ||
+        is_symbol(item, defun_memo_sym)) {
+      return true;
+    }
+    if (defines_functions(item)) return true;
+  }
+  return false;
+}
+
+// Name of the function a (defun (name ...) ...) or defun-memo form
+// defines, or nullptr
+Object *defun_name(Object *form) {
+  static SymbolId defun_sym = intern("defun");
+  static SymbolId defun_memo_sym = intern("defun-memo");
+  if (!is_list(form) || list_length(form) < 3) return nullptr;
+  auto *head = list_index(form, 0);
+  auto *fundef = list_index(form, 1);
+  if (!(is_symbol(head, defun_sym) || is_symbol(head, defun_memo_sym)) ||
+      !is_list(fundef) || list_length(fundef) < 1) {
+    return nullptr;
+  }
+  auto *name = list_index(fundef, 0);
+  return obj_type(name) == ObjType::Symbol ? name : nullptr;
+}
+
+// Expressions in tail position leave their value as the value of the
+// function, so calls there reuse the frame of the caller
+void compile_expr(Compiler &c, Object *expr, bool tail = false);
+
+// Compiles a sequence of expressions, leaving the value of the last one
+void compile_body(Compiler &c, std::span<Object *> l, size_t from,
+                  bool tail = false) {
+  if (from >= l.size()) {
+    emit(c, Op::Const, add_const(c, nil_obj), 1);
+    return;
+  }
+  for (size_t i = from; i < l.size(); ++i) {
+    bool last = i + 1 == l.size();
+    compile_expr(c, l[i], tail && last);
+    if (!last) emit(c, Op::Pop, 0, -1);
+  }
+}
+
+Proto *compile_function(Compiler &parent, char const *name,
+                        Object *fundef_list, size_t from, Object *body_expr,
+                        size_t body_from, bool is_lambda) {
+  auto *proto = new Proto();
+  proto->name = name;
+  proto->is_lambda = is_lambda;
+  auto params = list_members(fundef_list);
+  for (size_t i = from; i < params.size(); ++i) {
+    auto *param = params[i];
+    if (param == dot_obj) {
+      if (i != params.size() - 2 ||
+          obj_type(params[i + 1]) != ObjType::Symbol) {
+        proto->bad_arglist = true;
+        break;
+      }
+      proto->variadic = true;
+      proto->rest = sym_id(params[i + 1]);
+      break;
+    }
+    if (obj_type(param) != ObjType::Symbol) {
+      proto->bad_arglist = true;
+      break;
+    }
+    proto->params.push_back(sym_id(param));
+  }
+  Compiler fc;
+  fc.proto = proto;
+  fc.parent = &parent;
+  auto body = list_members(body_expr);
+  for (size_t i = body_from; i < body.size(); ++i) {
+    proto->owns_env = proto->owns_env || defines_functions(body[i]);
+  }
+  for (auto param : proto->params) declare_local(fc, param);
+  if (proto->variadic) declare_local(fc, proto->rest);
+  // Functions defined in the body are visible to each other from the start
+  for (size_t i = body_from; i < body.size(); ++i) {
+    if (auto *inner = defun_name(body[i])) resolve_binding(fc, sym_id(inner));
+  }
+  compile_body(fc, body, body_from, true);
+  emit(fc, Op::Return, 0, -1);
+  return proto;
+}
+
+void compile_function_obj(Compiler &c, Proto *proto) {
+  auto &protos = c.proto->chunk.protos;
+  protos.push_back(proto);
+  emit(c, Op::MakeFunction, protos.size() - 1, 1);
+}
+
+bool compile_if(Compiler &c, std::span<Object *> l, bool tail) {
+  if (l.size() != 4) return false;
+  compile_expr(c, l[1]);
+  u32 to_else = emit(c, Op::JumpIfFalse, 0, -1);
+  compile_expr(c, l[2], tail);
+  u32 to_end = emit(c, Op::Jump);
+  // only one of the branches leaves its value on the stack
+  adjust_depth(c, -1);
+  patch_arg(c, to_else, here(c));
+  compile_expr(c, l[3], tail);
+  patch_arg(c, to_end, here(c));
+  return true;
+}
+
+bool compile_cond(Compiler &c, std::span<Object *> l, bool tail) {
+  static SymbolId else_sym = intern("else");
+  if (l.size() < 2) return false;
+  for (size_t i = 1; i < l.size(); ++i) {
+    if (!is_list(l[i]) || list_length(l[i]) < 1) return false;
+  }
+  std::vector<u32> to_end;
+  bool has_otherwise = false;
+  for (size_t i = 1; i < l.size(); ++i) {
+    auto clause = list_members(l[i]);
+    // this is an "else" branch, and so just return the value since there
+    // was no matches before
+    if (is_symbol(clause[0], else_sym)) {
+      if (clause.size() == 1) {
+        emit(c, Op::Const, add_const(c, nil_obj), 1);
+      } else {
+        compile_body(c, clause, 1, tail);
+      }
+      has_otherwise = true;
+      break;
+    }
+    compile_expr(c, clause[0]);
+    u32 to_next = emit(c, Op::JumpIfFalse, 0, -1);
+    compile_body(c, clause, 1, tail);
+    to_end.push_back(emit(c, Op::Jump));
+    adjust_depth(c, -1);
+    patch_arg(c, to_next, here(c));
+  }
+  if (!has_otherwise) {
+    emit(c, Op::Const, add_const(c, nil_obj), 1);
+  }
+  for (auto at : to_end) patch_arg(c, at, here(c));
+  return true;
+}
+
+bool compile_let(Compiler &c, std::span<Object *> l, bool tail) {
+  if (l.size() != 3 || !is_list(l[1])) return false;
+  auto bindings = list_members(l[1]);
+  for (auto *let_pair : bindings) {
+    if (!is_list(let_pair) || list_length(let_pair) < 2 ||
+        obj_type(list_index(let_pair, 0)) != ObjType::Symbol) {
+      return false;
+    }
+  }
+  size_t outer_names = c.names.size();
+  for (auto *let_pair : bindings) {
+    compile_expr(c, list_index(let_pair, 1));
+    u32 slot = declare_local(c, sym_id(list_index(let_pair, 0)));
+    emit_store(c, slot_ref(c, slot));
+  }
+  compile_expr(c, l[2], tail);
+  c.names.resize(outer_names);
+  return true;
+}
+
+// (while condition body...)
+bool compile_while(Compiler &c, std::span<Object *> l) {
+  if (l.size() < 2) return false;
+  u32 top = here(c);
+  compile_expr(c, l[1]);
+  u32 to_end = emit(c, Op::JumpIfFalse, 0, -1);
+  for (size_t i = 2; i < l.size(); ++i) {
+    compile_expr(c, l[i]);
+    emit(c, Op::Pop, 0, -1);
+  }
+  emit(c, Op::Jump, top);
+  patch_arg(c, to_end, here(c));
+  emit(c, Op::Const, add_const(c, nil_obj), 1);
+  return true;
+}
+
+// (dotimes (var count) body...) and (dolist (var list) body...). The
+// counter and the count or the list stay on the stack, the variable is a
+// local of the loop body assigned on every iteration. Only its name goes
+// out of scope after the loop: variables the body binds with setq belong
+// to the function, as in eval_for_loop.
+bool compile_for(Compiler &c, std::span<Object *> l, Op step) {
+  if (l.size() < 2 || !is_list(l[1]) || list_length(l[1]) != 2 ||
+      obj_type(list_index(l[1], 0)) != ObjType::Symbol) {
+    return false;
+  }
+  compile_expr(c, list_index(l[1], 1));
+  emit(c, Op::Const, add_const(c, create_num_obj(0)), 1);
+  size_t var_name = c.names.size();
+  u32 slot = declare_local(c, sym_id(list_index(l[1], 0)));
+  u32 top = emit(c, step, 0, 1);
+  emit_store(c, slot_ref(c, slot));
+  for (size_t i = 2; i < l.size(); ++i) {
+    compile_expr(c, l[i]);
+    emit(c, Op::Pop, 0, -1);
+  }
+  emit(c, Op::Jump, top);
+  patch_arg(c, top, here(c));
+  c.names.erase(c.names.begin() + var_name);
+  emit(c, Op::Pop, 0, -1);
+  emit(c, Op::Pop, 0, -1);
+  emit(c, Op::Const, add_const(c, nil_obj), 1);
+  return true;
+}
+
+bool compile_special_form(Compiler &c, char const *name, Object *expr,
+                          bool tail) {
+  auto l = list_members(expr);
+  if (!strcmp(name, "setq")) {
+    if (l.size() != 3 || obj_type(l[1]) != ObjType::Symbol) return false;
+    compile_expr(c, l[2]);
+    // assigns the variable in scope, even a captured one, or binds a new one
+    auto ref = resolve(c, sym_id(l[1]));
+    if (ref.kind == VarKind::Global) ref = resolve_binding(c, sym_id(l[1]));
+    emit_store(c, ref);
+    emit(c, Op::Const, add_const(c, nil_obj), 1);
+    return true;
+  }
+  if (!strcmp(name, "begin")) {
+    if (l.size() < 2) return false;
+    compile_body(c, l, 1, tail);
+    return true;
+  }
+  if (!strcmp(name, "if")) return compile_if(c, l, tail);
+  if (!strcmp(name, "cond")) return compile_cond(c, l, tail);
+  if (!strcmp(name, "let")) return compile_let(c, l, tail);
+  if (!strcmp(name, "while")) return compile_while(c, l);
+  if (!strcmp(name, "dotimes")) return compile_for(c, l, Op::ForCount);
+  if (!strcmp(name, "dolist")) return compile_for(c, l, Op::ForMember);
+  bool memo = !strcmp(name, "defun-memo");
+  if (!strcmp(name, "defun") || memo) {
+    if (l.size() < 3 || !is_list(l[1]) || list_length(l[1]) < 1) return false;
+    auto *funname = list_index(l[1], 0);
+    if (obj_type(funname) != ObjType::Symbol) return false;
+    // bound before compiling the body so that it can refer to itself
+    auto ref = resolve_binding(c, sym_id(funname));
+    auto *proto = compile_function(c, sym_name(funname).c_str(), l[1], 1,
+                                   expr, 2, false);
+    if (memo) emit(c, Op::Const, add_const(c, memoize_builtin), 1);
+    compile_function_obj(c, proto);
+    if (memo) emit(c, Op::Call, 1, -1);
+    emit(c, Op::Dup, 0, 1);
+    emit_store(c, ref);
+    return true;
+  }
+  if (!strcmp(name, "lambda")) {
+    if (l.size() != 3 || !is_list(l[1])) return false;
+    auto *proto = compile_function(c, "lambda", l[1], 0, expr, 2, true);
+    compile_function_obj(c, proto);
+    return true;
+  }
+  if (!strcmp(name, "timeit")) {
+    if (l.size() != 2) return false;
+    emit(c, Op::TimerStart);
+    compile_expr(c, l[1]);
+    // discard the result
+    emit(c, Op::Pop, 0, -1);
+    emit(c, Op::TimerStop, 0, 1);
+    return true;
+  }
+  return false;
+}
+
+void compile_literal(Compiler &c, Object *expr) {
+  auto items = list_members(expr);
+  bool constant = true;
+  for (auto *item : items) {
+    if (!is_self_evaluating(item)) {
+      constant = false;
+      break;
+    }
+  }
+  if (constant) {
+    expr->flags |= OF_EVALUATED;
+    emit(c, Op::Const, add_const(c, expr), 1);
+    return;
+  }
+  // Literal lists are evaluated in place the first time they're reached,
+  // the same list object is returned afterwards
+  u32 k = add_const(c, expr);
+  emit(c, Op::LiteralGuard, k);
+  u32 to_end = emit_word(c, 0);
+  for (auto *item : items) compile_expr(c, item);
+  emit(c, Op::FillLiteral, k, 1 - (int)items.size());
+  patch_word(c, to_end, here(c));
+}
+
+// Built-in the global symbol is bound to at compile time, if any
+Object *builtin_of(Compiler &c, Object *head) {
+  if (obj_type(head) != ObjType::Symbol) return nullptr;
+  if (resolve(c, sym_id(head)).kind != VarKind::Global) return nullptr;
+  auto *val = get_global(sym_id(head));
+  bool builtin = obj_type(val) == ObjType::Function &&
+                 (obj_flags(val) & (OF_BUILTIN | OF_SPECIAL)) == OF_BUILTIN;
+  return builtin ? val : nullptr;
+}
+
+// Struct accessor or setter the global symbol is bound to at compile time
+// that the call can load or store the slot of, if any
+Object *slot_access_of(Compiler &c, Object *head, u32 nargs) {
+  if (obj_type(head) != ObjType::Symbol) return nullptr;
+  if (resolve(c, sym_id(head)).kind != VarKind::Global) return nullptr;
+  auto *val = get_global(sym_id(head));
+  if (obj_type(val) != ObjType::Function || !(obj_flags(val) & OF_STRUCT_OP)) {
+    return nullptr;
+  }
+  auto kind = val->val.sop_value->kind;
+  if (kind == StructOpKind::Get && nargs == 1) return val;
+  if (kind == StructOpKind::Set && nargs == 2) return val;
+  return nullptr;
+}
+
+void compile_call(Compiler &c, Object *expr, bool tail) {
+  auto l = list_members(expr);
+  compile_expr(c, l[0]);
+  size_t n = l.size();
+  // a dot on the pre-last position spreads the list that follows it
+  bool spread = n >= 3 && l[n - 2] == dot_obj;
+  u32 nfixed = spread ? n - 3 : n - 1;
+  u32 expr_k = 0;
+  std::vector<u32> guards;
+  for (u32 i = 0; i < nfixed; ++i) {
+    auto *arg = l[i + 1];
+    if (!is_self_evaluating(arg)) {
+      if (guards.empty()) expr_k = add_const(c, expr);
+      emit(c, Op::RestGuard, i);
+      emit_word(c, expr_k);
+      emit_word(c, nfixed);
+      guards.push_back(emit_word(c, 0));
+    }
+    compile_expr(c, arg);
+  }
+  for (auto at : guards) patch_word(c, at, here(c));
+  auto *builtin = spread ? nullptr : builtin_of(c, l[0]);
+  auto *slot_access = spread ? nullptr : slot_access_of(c, l[0], nfixed);
+  if (spread) {
+    compile_expr(c, l[n - 1]);
+    emit(c, Op::CallSpread, nfixed + 1, -(int)(nfixed + 1));
+  } else if (builtin && builtin_accepts(builtin->val.bf_value.spec, nfixed)) {
+    // the arguments are checked once here rather than on every call
+    emit(c, Op::CallBuiltin, nfixed, -(int)nfixed);
+    emit_word(c, add_const(c, builtin));
+  } else if (slot_access) {
+    emit(c, Op::SlotAccess, nfixed, -(int)nfixed);
+    emit_word(c, add_const(c, slot_access));
+  } else {
+    emit(c, tail ? Op::TailCall : Op::Call, nfixed, -(int)nfixed);
+  }
+}
+
+void compile_expr(Compiler &c, Object *expr, bool tail) {
+  if (is_self_evaluating(expr)) {
+    emit(c, Op::Const, add_const(c, expr), 1);
+    return;
+  }
+  if (obj_type(expr) == ObjType::Symbol) {
+    emit_load(c, resolve(c, sym_id(expr)));
+    return;
+  }
+  if (obj_flags(expr) & OF_LIST_LITERAL) {
+    compile_literal(c, expr);
+    return;
+  }
+  if (list_length(expr) == 0) {
+    emit(c, Op::Const, add_const(c, expr), 1);
+    return;
+  }
+  auto *head = list_index(expr, 0);
+  bool shadowed = obj_type(head) == ObjType::Symbol &&
+                  resolve(c, sym_id(head)).kind != VarKind::Global;
+  if (auto *sf = shadowed ? nullptr : special_form_of(head)) {
+    if (compile_special_form(c, fun_name(sf), expr, tail)) return;
+    // Forms the compiler doesn't know (or malformed ones, so that they
+    // report errors the usual way) are handed to the special form itself.
+    // Those only see the global variables.
+    emit(c, Op::CallSpecial, add_const(c, expr), 1);
+    emit_word(c, add_const(c, sf));
+    return;
+  }
+  compile_call(c, expr, tail);
+}
+
+Proto *compile_toplevel(Object *expr) {
+  auto *proto = new Proto();
+  proto->name = "toplevel";
+  proto->owns_env = defines_functions(expr);
+  Compiler c;
+  c.proto = proto;
+  c.toplevel = true;
+  compile_expr(c, expr);
+  emit(c, Op::Return, 0, -1);
+  return proto;
+}
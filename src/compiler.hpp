@@ -0,0 +1,129 @@
+#ifndef COMPILER_HPP
+#define COMPILER_HPP
+
+#include <vector>
+
+#include "types.hpp"
+
+struct Object;
+
+// Every instruction is a 32-bit word: the opcode in the lowest byte and an
+// inline 24-bit argument. Some instructions are followed by extra operand
+// words, noted below.
+enum class Op : u8 {
+  // push consts[a]
+  Const,
+  // push the global bound to the symbol with id a
+  LoadGlobal,
+  // pop a value and bind the global symbol with id a to it
+  StoreGlobal,
+  // push/pop the a-th slot of the current frame
+  LoadLocal,
+  StoreLocal,
+  // push/pop slot (a & 0xFFFF) of the environment (a >> 16) levels up
+  // from the current one
+  LoadEnv,
+  StoreEnv,
+  Pop,
+  Dup,
+  // pc = a
+  Jump,
+  // pop a value, pc = a if it's falsy
+  JumpIfFalse,
+  // Steps of dotimes and dolist loops, over a counter on the top of the
+  // stack and the number it counts to (ForCount) or the list it goes
+  // through (ForMember) below it: pc = a once the counter reaches the end,
+  // otherwise push the counter or the member at it and increment the
+  // counter in place
+  ForCount,
+  ForMember,
+  // Variadic functions get their rest arguments unevaluated. Guards the
+  // evaluation of the a-th argument of a call: if the callee takes it as a
+  // rest argument, push the raw forms instead and skip to the call.
+  // Operand words: call expression const, number of fixed args, target pc
+  RestGuard,
+  // call the function below a arguments on the stack
+  Call,
+  // like Call, but the last of the a arguments is a list to spread
+  CallSpread,
+  // Call to the built-in consts[k] the callee was bound to when compiled,
+  // which takes a arguments: calls it without checking them again. Runs
+  // as Call if the callee isn't that built-in anymore.
+  // Operand words: k
+  CallBuiltin,
+  // Call to the struct accessor or setter consts[k] the callee was bound to
+  // when compiled, with a arguments (1 or 2): loads or stores the slot of
+  // the record directly. Runs as Call if the callee isn't that function
+  // anymore or the record isn't of its type.
+  // Operand words: k
+  SlotAccess,
+  // Call in tail position, always followed by Return. Compiled callees
+  // replace the current frame instead of nesting.
+  TailCall,
+  // pass the unevaluated expression consts[a] to a special form
+  // Operand words: special form const
+  CallSpecial,
+  // push a new function object for protos[a] closed over the current
+  // environment
+  MakeFunction,
+  // remember the current time / push the milliseconds passed since the
+  // matching TimerStart as a string
+  TimerStart,
+  TimerStop,
+  // push the literal list consts[a] and jump if it's already evaluated
+  // Operand words: target pc
+  LiteralGuard,
+  // pop the evaluated members of the literal list consts[a] into it
+  FillLiteral,
+  Return,
+};
+
+struct Proto;
+
+struct Chunk {
+  std::vector<u32> code;
+  std::vector<Object *> consts;
+  std::vector<Proto *> protos;
+  // maximum number of stack slots the code can use at once
+  u32 max_stack = 0;
+};
+
+// Compiled function (or top-level form). The constants are only rooted
+// while the proto is live: a running proto is found on the VM frames, the
+// others through the function objects and eval cache entries that hold
+// them (see gc_mark_proto).
+struct Proto {
+  char const *name;
+  std::vector<SymbolId> params;
+  // symbol receiving the list of variadic arguments
+  bool variadic = false;
+  SymbolId rest = 0;
+  bool is_lambda = false;
+  // set if the argument list couldn't be parsed, reported on call
+  bool bad_arglist = false;
+  // Number of frame slots: the parameters, the rest list, then the locals
+  // introduced by let, setq and defun
+  u32 nslots = 0;
+  // Functions that define other functions keep their slots in a heap
+  // environment the inner ones can capture, the rest use the VM stack
+  bool owns_env = false;
+  Chunk chunk;
+  // The compiler's reference, then one per function object made from it
+  // and per holder of a top-level proto. The inner protos are held by
+  // their parent.
+  u32 refs = 1;
+  // the major collection the constants were last marked in
+  u64 marked_in = 0;
+};
+
+inline Op instr_op(u32 instr) { return (Op)(instr & 0xFF); }
+inline u32 instr_arg(u32 instr) { return instr >> 8; }
+
+// The caller owns the reference to the new proto, see release_proto
+Proto *compile_toplevel(Object *expr);
+void retain_proto(Proto *proto);
+// Frees the proto and the inner ones no function object holds once the
+// last reference is gone
+void release_proto(Proto *proto);
+
+#endif
@@ -14,8 +14,9 @@ size_t list_length(const Object *);
 using fmt::format;
 
 inline void error_msg(const std::string &msg) {
-  printf("Error in %s at [%d:%d]: %s\n", IS.file_name, IS.line, IS.col,
-         msg.c_str());
+  auto &reader = *IS.reader;
+  printf("Error in %s at [%d:%d]: %s\n", reader.file_name, reader.line,
+         reader.col, msg.c_str());
 }
 
 inline void eof_error() { error_msg("EOF"); }
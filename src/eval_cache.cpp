@@ -0,0 +1,74 @@
+#include "eval_cache.hpp"
+
+#include "compiler.hpp"
+#include "interpreter.hpp"
+#include "objects.hpp"
+#include "optimizer.hpp"
+#include "vm.hpp"
+
+EvalCache eval_cache;
+
+void erase_entry(std::list<EvalCacheEntry>::iterator entry) {
+  if (entry->proto != nullptr) release_proto(entry->proto);
+  eval_cache.entries.erase(entry);
+}
+
+// Whether evaluating the form twice gives the same as reading it twice:
+// literal lists evaluate their items once, in place
+bool reusable_form(Object *form) {
+  if (obj_type(form) != ObjType::List || (obj_flags(form) & OF_EVALUATED)) {
+    return true;
+  }
+  if (obj_flags(form) & OF_LIST_LITERAL) return false;
+  for (auto *item : list_members(form)) {
+    if (!reusable_form(item)) return false;
+  }
+  return true;
+}
+
+Object *eval_form(Object *form, Proto *proto) {
+  if (proto != nullptr) return vm_run_toplevel(proto);
+  return eval_expr(form);
+}
+
+Object *eval_string(std::string const &text) {
+  auto &cache = eval_cache;
+  auto &reader = *IS.reader;
+  if (auto it = cache.index.find(text); it != cache.index.end()) {
+    auto entry = it->second;
+    if (!IS.fold_constants || entry->fold_generation == fold_generation()) {
+      ++cache.hits;
+      cache.entries.splice(cache.entries.begin(), cache.entries, entry);
+      reader.line = entry->line;
+      reader.col = entry->col;
+      // the entry may be evicted by the evals it runs
+      return eval_form(entry->form, entry->proto);
+    }
+    cache.index.erase(it);
+    erase_entry(entry);
+  }
+  ++cache.misses;
+  reader.text = text.c_str();
+  reader.text_pos = 0;
+  reader.text_len = text.size();
+  reader.line = 1;
+  reader.col = 0;
+  auto *form = read_expr();
+  if (form == nullptr) return nil_obj;
+  if (IS.fold_constants) form = fold_constants(form);
+  auto *proto = IS.tree_walk ? nullptr : compile_toplevel(form);
+  if (!reusable_form(form)) {
+    auto *res = eval_form(form, proto);
+    if (proto != nullptr) release_proto(proto);
+    return res;
+  }
+  cache.entries.push_front(
+      {text, form, proto, fold_generation(), reader.line, reader.col});
+  cache.index.emplace(cache.entries.front().text, cache.entries.begin());
+  while (cache.entries.size() > EVAL_CACHE_CAPACITY) {
+    cache.index.erase(cache.entries.back().text);
+    erase_entry(std::prev(cache.entries.end()));
+    ++cache.evictions;
+  }
+  return eval_form(form, proto);
+}
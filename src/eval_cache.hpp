@@ -0,0 +1,53 @@
+#ifndef EVAL_CACHE_HPP
+#define EVAL_CACHE_HPP
+
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "types.hpp"
+
+struct Object;
+struct Proto;
+
+// The eval built-in keeps the forms it reads by source text, so evaluating
+// the same text again skips the reading, the folding and the compiling. At
+// most EVAL_CACHE_CAPACITY texts are kept, the least recently used one is
+// evicted first. A text is read again once the names its form was folded
+// with change (see fold_generation). Forms with literal lists that
+// evaluate their items aren't kept, every eval evaluates those again.
+
+const size_t EVAL_CACHE_CAPACITY = 256;
+
+struct EvalCacheEntry {
+  std::string text;
+  // the folded form, evaluated by the tree-walker
+  Object *form;
+  // the form compiled for the VM, nullptr with the tree-walker. The entry
+  // holds a reference to it, which roots its constants.
+  Proto *proto;
+  u64 fold_generation;
+  // where the reader stopped, for the errors of the evaluation
+  u32 line;
+  u32 col;
+};
+
+struct EvalCache {
+  // the most recently used first
+  std::list<EvalCacheEntry> entries;
+  // the keys view the texts of the entries
+  std::unordered_map<std::string_view, std::list<EvalCacheEntry>::iterator>
+      index;
+  u64 hits = 0;
+  u64 misses = 0;
+  u64 evictions = 0;
+};
+
+extern EvalCache eval_cache;
+
+// Evaluates the first form of the text with the selected evaluator, reads
+// with the current reader context
+Object *eval_string(std::string const &text);
+
+#endif
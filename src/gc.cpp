@@ -0,0 +1,372 @@
+#include "gc.hpp"
+
+#include <fmt/core.h>
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "compiler.hpp"
+#include "eval_cache.hpp"
+#include "interpreter.hpp"
+#include "memo.hpp"
+#include "objects.hpp"
+#include "persistent_map.hpp"
+#include "structs.hpp"
+#include "vm.hpp"
+
+using fmt::format;
+using std::chrono::duration;
+using std::chrono::high_resolution_clock;
+
+GarbageCollector GC;
+
+void init_gc() {
+  GC.log_file =
+      new std::ofstream(GC_LOG_FILE, std::ios_base::app | std::ios_base::ate);
+  *GC.log_file << "Initializing GC..." << std::endl;
+  // the lines are buffered, see gc_log
+  std::atexit([]() { GC.log_file->flush(); });
+}
+
+void gc_pin(Object *obj) {
+  obj->flags |= OF_PERSISTENT;
+  GC.pinned.push_back(obj);
+}
+
+// Objects with any of these bits are taken as live without being traced
+static u8 skip_bits = GC_MARK;
+
+inline void mark(Object *obj) {
+  if (obj == nullptr || !is_heap_obj(obj) || (obj->gc_bits & skip_bits)) {
+    return;
+  }
+  obj->gc_bits |= GC_MARK;
+  GC.mark_stack.push_back({obj, 0, 0});
+}
+
+void gc_shade(Object *obj) { mark(obj); }
+
+void gc_mark_proto(Proto *proto) {
+  // the cycle in progress
+  u64 cycle = GC.stats.major_cycles + 1;
+  if (GC.phase != GCPhase::Marking || proto->marked_in == cycle) return;
+  proto->marked_in = cycle;
+  for (auto *obj : proto->chunk.consts) mark(obj);
+  for (auto *inner : proto->chunk.protos) gc_mark_proto(inner);
+}
+
+// Marks the members of a container from the given one on, a chunk at a
+// time so that big ones don't take a whole slice. Returns how many.
+template <typename M>
+inline size_t trace_members(GreyObject grey, size_t size, M mark_member) {
+  size_t to = std::min(size, grey.from + GC_TRACE_CHUNK);
+  if (to < size) GC.mark_stack.push_back({grey.obj, to, size});
+  for (size_t i = grey.from; i < to; ++i) mark_member(i);
+  return to - grey.from;
+}
+
+// Marks the objects the object refers to, returns about how many
+inline size_t trace(GreyObject grey) {
+  auto *obj = grey.obj;
+  switch (obj->type) {
+    case ObjType::List: {
+      auto items = list_members(obj);
+      return trace_members(grey, items.size(),
+                           [&](size_t i) { mark(items[i]); });
+    }
+    case ObjType::Function: {
+      if (obj->flags & OF_BUILTIN) break;
+      if (obj->flags & OF_MEMOIZED) {
+        auto &cache = *obj->val.memo_value.cache;
+        mark(obj->val.memo_value.fun);
+        for (auto &entry : cache.entries) {
+          for (auto *arg : entry.args) mark(arg);
+          mark(entry.result);
+        }
+        return cache.entries.size() + 1;
+      }
+      // the ops of structs only refer to their StructOp, outside the heap
+      if (obj->flags & OF_STRUCT_OP) break;
+      if (obj->flags & OF_COMPILED) {
+        mark(obj->val.cf_value.env);
+        gc_mark_proto(obj->val.cf_value.proto);
+      } else {
+        mark(obj->val.f_value.funargs);
+        mark(obj->val.f_value.funbody);
+      }
+    } break;
+    case ObjType::Environment: {
+      auto &slots = *obj->val.env_value.slots;
+      if (grey.from == 0) mark(obj->val.env_value.parent);
+      return trace_members(grey, slots.size(),
+                           [&](size_t i) { mark(slots[i]); });
+    }
+    case ObjType::HashTable: {
+      // A chunk of slots at a time. Rehashing the table between the chunks
+      // moves the entries around, so it's traced again: the size of the
+      // grey tables is their rehash count.
+      auto &table = *obj->val.ht_value;
+      if (grey.from != 0 && grey.size != table.rehashes) grey.from = 0;
+      size_t capacity = ht_capacity(table);
+      size_t to = std::min(capacity, grey.from + GC_TRACE_CHUNK);
+      if (to < capacity) GC.mark_stack.push_back({obj, to, table.rehashes});
+      for (size_t i = grey.from; i < to; ++i) {
+        if (!ht_slot_full(table, i)) continue;
+        mark(table.slots[i].key);
+        mark(table.slots[i].value);
+      }
+      return to - grey.from;
+    }
+    case ObjType::PersistentMap: {
+      mark(obj->val.pmap_value.root);
+    } break;
+    case ObjType::Struct: {
+      auto *slots = obj->val.struct_value.slots;
+      return trace_members(grey, struct_size(obj),
+                           [&](size_t i) { mark(slots[i]); });
+    }
+    case ObjType::MapNode: {
+      auto *items = obj->val.node_value.items;
+      return trace_members(grey, map_node_size(obj),
+                           [&](size_t i) { mark(items[i]); });
+    }
+    default: {
+    } break;
+  }
+  return 1;
+}
+
+void mark_roots(Object *env, size_t pinned_from) {
+  for (size_t i = pinned_from; i < GC.pinned.size(); ++i) mark(GC.pinned[i]);
+  for (auto *scope = IS.symtable; scope != nullptr; scope = scope->prev) {
+    for (auto &var : scope->map) mark(var.second);
+  }
+  for (Object **slot = VM.stack; slot < VM.sp; ++slot) mark(*slot);
+  for (auto &frame : VM.frames) {
+    mark(frame.env);
+    mark(frame.fobj);
+    gc_mark_proto(frame.proto);
+  }
+  for (auto &entry : eval_cache.entries) {
+    mark(entry.form);
+    if (entry.proto != nullptr) gc_mark_proto(entry.proto);
+  }
+  mark(env);
+}
+
+// Work done by the current major slice, in bytes: the members traced
+// count as a pointer each, the pages swept as their size
+static u64 slice_work = 0;
+
+// Traces grey objects while keep_going() returns true, checked every 1024
+// members or so. Returns how many objects.
+template <typename G>
+u64 drain_mark_stack(G keep_going) {
+  u64 traced = 0;
+  size_t work = 0;
+  while (!GC.mark_stack.empty()) {
+    auto grey = GC.mark_stack.back();
+    GC.mark_stack.pop_back();
+    size_t members = trace(grey);
+    work += members;
+    slice_work += members * sizeof(Object *);
+    ++traced;
+    if (work >= 1024) {
+      work = 0;
+      if (!keep_going()) break;
+    }
+  }
+  return traced;
+}
+
+inline double ms_since(high_resolution_clock::time_point start) {
+  duration<double, std::milli> ms = high_resolution_clock::now() - start;
+  return ms.count();
+}
+
+void record_pause(double ms) {
+  auto &stats = GC.stats;
+  stats.pauses_ms.push_back(ms);
+  stats.max_pause_ms = std::max(stats.max_pause_ms, ms);
+  stats.total_pause_ms += ms;
+}
+
+// Not flushed line by line, there's one per minor collection and major
+// slice; the log is flushed at exit
+inline void gc_log(std::string const &line) {
+  if (GC.log_file != nullptr) *GC.log_file << line << '\n';
+}
+
+// Frees the unmarked objects, the marked ones survive with survivor_bits
+inline bool sweep_dead(Object *obj, u8 survivor_bits) {
+  if (obj->gc_bits & GC_MARK) {
+    obj->gc_bits = (obj->gc_bits & ~GC_MARK) | survivor_bits;
+    return false;
+  }
+  finalize_obj(obj);
+  return true;
+}
+
+void minor_collection(Object *env) {
+  auto start_time = high_resolution_clock::now();
+  skip_bits = GC_MARK | GC_OLD;
+  // the old pinned objects can only refer to young ones when remembered
+  mark_roots(env, GC.pinned_old);
+  GC.pinned_old = GC.pinned.size();
+  for (auto *obj : GC.remembered) {
+    obj->gc_bits &= ~GC_REMEMBERED;
+    mark(obj);
+  }
+  // the young survivors are promoted, so no old object refers to a young
+  // one afterwards
+  GC.remembered.clear();
+  u64 marked = drain_mark_stack([]() { return true; });
+  u64 freed = heap_sweep(
+      [](void *cell) {
+        auto *obj = (Object *)cell;
+        if (obj->gc_bits & GC_OLD) return false;
+        return sweep_dead(obj, GC_OLD);
+      },
+      true);
+  GC.old_bytes = heap_live_bytes();
+  double pause = ms_since(start_time);
+  record_pause(pause);
+  ++GC.stats.minor_cycles;
+  GC.stats.objects_freed += freed;
+  gc_log(format(
+      "minor {}: marked {} objects, freed {}, {} KB in use in {} pages, "
+      "{} KB nursery. Took {} ms",
+      GC.stats.minor_cycles, marked, freed, GC.old_bytes >> 10,
+      HEAP.stats.pages, GC.nursery_size >> 10, pause));
+  // the work is proportional to the nursery, so it's sized to the budget
+  if (pause > GC.pause_budget_ms) {
+    GC.nursery_size = std::max(GC_MIN_NURSERY_SIZE, GC.nursery_size / 2);
+  } else if (pause < GC.pause_budget_ms / 4) {
+    GC.nursery_size = std::min(GC_MAX_NURSERY_SIZE, GC.nursery_size * 2);
+  }
+  GC.next_collection = heap_bytes_allocated() + GC.nursery_size;
+}
+
+void start_major(Object *env) {
+  GC.phase = GCPhase::Marking;
+  GC.major = MajorCycle();
+  GC.major.pinned_from = GC.pinned.size();
+  GC.alloc_bits = GC_MARK;
+  skip_bits = GC_MARK;
+  // the whole heap is traced and every survivor becomes old, nothing is
+  // remembered until the sweeping
+  for (auto *obj : GC.remembered) obj->gc_bits &= ~GC_REMEMBERED;
+  GC.remembered.clear();
+  mark_roots(env, 0);
+  GC.major.allocated = heap_bytes_allocated();
+}
+
+void finish_marking() {
+  GC.pinned_old = GC.pinned.size();
+  GC.phase = GCPhase::Sweeping;
+  // Every object left is about to become old and the new ones aren't swept
+  // before the next major collection, so they're old as well. The first
+  // minor collection would otherwise have all of them to trace.
+  GC.alloc_bits = GC.generational ? GC_OLD : 0;
+  heap_sweep_begin(false);
+}
+
+void finish_major() {
+  GC.phase = GCPhase::Idle;
+  GC.alloc_bits = 0;
+  u64 live_bytes = heap_live_bytes();
+  GC.old_bytes = live_bytes;
+  // the old generation may grow as much as it holds before the next major
+  // collection
+  GC.next_major = live_bytes + std::max(GC_MIN_THRESHOLD, live_bytes);
+  auto &major = GC.major;
+  ++GC.stats.major_cycles;
+  GC.stats.objects_freed += major.freed;
+  gc_log(format(
+      "major {}: marked {} objects, freed {}, {} KB in use in {} pages. "
+      "Took {} ms in {} slices, the longest {} ms",
+      GC.stats.major_cycles, major.marked, major.freed, live_bytes >> 10,
+      HEAP.stats.pages, major.total_ms, major.slices, major.longest_slice_ms));
+  u64 next_in = GC.generational ? GC.nursery_size
+                                : std::max(GC_MIN_THRESHOLD, live_bytes);
+  GC.next_collection = heap_bytes_allocated() + next_in;
+}
+
+void major_slice(Object *env) {
+  auto start_time = high_resolution_clock::now();
+  // However short the pause budget, the slice keeps up with what the
+  // program allocated since the previous one, or the collection could never
+  // finish while the heap grows
+  u64 allocated = heap_bytes_allocated() - GC.major.allocated;
+  u64 min_work = GC_SLICE_WORK_RATIO * allocated;
+  slice_work = 0;
+  auto keep_going = [&]() {
+    return ms_since(start_time) < GC.pause_budget_ms || slice_work < min_work;
+  };
+  auto phase = GC.phase;
+  u64 marked = 0;
+  u64 freed = 0;
+  while (GC.phase == GCPhase::Marking) {
+    marked += drain_mark_stack(keep_going);
+    if (!GC.mark_stack.empty()) break;
+    // The roots are changed without barriers: they're scanned again, the
+    // marking is over once that finds nothing new
+    mark_roots(env, GC.major.pinned_from);
+    if (GC.mark_stack.empty()) {
+      finish_marking();
+    } else if (!keep_going()) {
+      break;
+    }
+  }
+  bool done = false;
+  if (GC.phase == GCPhase::Sweeping && keep_going()) {
+    u8 survivor_bits = GC.generational ? GC_OLD : 0;
+    done = heap_sweep_some(
+        [survivor_bits](void *cell) {
+          return sweep_dead((Object *)cell, survivor_bits);
+        },
+        [&]() {
+          slice_work += HEAP_PAGE_SIZE;
+          return keep_going();
+        },
+        freed);
+  }
+  double pause = ms_since(start_time);
+  record_pause(pause);
+  auto &major = GC.major;
+  ++major.slices;
+  major.marked += marked;
+  major.freed += freed;
+  major.longest_slice_ms = std::max(major.longest_slice_ms, pause);
+  major.total_ms += pause;
+  gc_log(format("major slice {} ({}): marked {} objects, freed {}. Took {} ms",
+                major.slices, phase == GCPhase::Marking ? "mark" : "sweep",
+                marked, freed, pause));
+  if (done) {
+    finish_major();
+  } else {
+    GC.major.allocated = heap_bytes_allocated();
+    GC.next_collection = GC.major.allocated + GC_SLICE_INTERVAL;
+  }
+}
+
+void gc_step(Object *env) {
+  if (GC.phase == GCPhase::Idle) {
+    if (GC.generational && GC.old_bytes < GC.next_major) {
+      minor_collection(env);
+      return;
+    }
+    start_major(env);
+  }
+  major_slice(env);
+}
+
+double gc_pause_percentile(double share) {
+  auto pauses = GC.stats.pauses_ms;
+  if (pauses.empty()) return 0;
+  size_t k = std::min(pauses.size() - 1, (size_t)(share * pauses.size()));
+  std::nth_element(pauses.begin(), pauses.begin() + k, pauses.end());
+  return pauses[k];
+}
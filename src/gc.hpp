@@ -0,0 +1,148 @@
+#ifndef GC_HPP
+#define GC_HPP
+
+#include <fstream>
+#include <vector>
+
+#include "heap.hpp"
+#include "types.hpp"
+
+// Precise mark-and-sweep collector with two generations. The collector only
+// runs at safepoints, where every live object is reachable from the roots:
+//   - pinned objects (interned symbols, built-ins), see gc_pin
+//   - the symbol table chain
+//   - the VM stack, and the environments, functions and constants of the
+//     VM call frames
+//   - the forms and constants of the eval cache entries
+//   - the environment of the code that reached the safepoint
+// Native code holding objects nothing else refers to mustn't reach a
+// safepoint: the VM collects on calls, the tree-walker only between
+// top-level forms.
+//
+// Objects surviving a collection become old. A minor collection runs every
+// time the nursery is full: it only marks and sweeps the young objects,
+// taking the old ones as live. Young objects stored in old ones are
+// remembered by the write barrier (see gc_write_barrier) and marked as
+// roots. The nursery is resized to keep the minor collections
+// within the pause budget.
+//
+// A major collection of the whole heap starts once the old generation has
+// grown by GC_MIN_THRESHOLD bytes, or as much as it held after the previous
+// major one. It's incremental: the marking and the sweeping are done in
+// slices of at most the pause budget, one every GC_SLICE_INTERVAL bytes
+// allocated. A slice goes past the budget until it has done
+// GC_SLICE_WORK_RATIO times the work of what was allocated since the
+// previous one, so that the collection keeps up with the program. While
+// marking, the objects are white (unmarked), grey (marked, on the mark
+// stack) or black (marked and traced). New objects are black, the write
+// barrier greys the white objects stored in marked ones, and the roots are
+// scanned again before the marking is over.
+
+const auto GC_LOG_FILE = "lisp-gc.log";
+const u64 GC_MIN_NURSERY_SIZE = 64 * 1024;
+const u64 GC_MAX_NURSERY_SIZE = 16 * 1024 * 1024;
+const u64 GC_MIN_THRESHOLD = 4 * 1024 * 1024;
+const u64 GC_SLICE_INTERVAL = 256 * 1024;
+// A major slice does at least this many bytes of work (see slice_work) per
+// byte allocated since the previous one
+const u64 GC_SLICE_WORK_RATIO = 2;
+const double GC_DEFAULT_PAUSE_MS = 5;
+
+// Most members of a container traced at once
+const size_t GC_TRACE_CHUNK = 4096;
+
+// Object::gc_bits
+const u8 GC_MARK = 0x1;
+const u8 GC_OLD = 0x2;
+const u8 GC_REMEMBERED = 0x4;
+
+struct Object;
+struct Proto;
+
+// Object on the mark stack, the members before from (out of size when the
+// tracing started) are already traced
+struct GreyObject {
+  Object *obj;
+  size_t from;
+  size_t size;
+};
+
+enum class GCPhase : u8 { Idle, Marking, Sweeping };
+
+struct GCStats {
+  u64 minor_cycles = 0;
+  u64 major_cycles = 0;
+  u64 objects_freed = 0;
+  // of every minor collection and major collection slice
+  std::vector<double> pauses_ms;
+  double max_pause_ms = 0;
+  double total_pause_ms = 0;
+};
+
+// Progress of the major collection in progress
+struct MajorCycle {
+  u32 slices = 0;
+  u64 marked = 0;
+  u64 freed = 0;
+  double longest_slice_ms = 0;
+  double total_ms = 0;
+  // pinned objects before this index were marked at the start
+  size_t pinned_from = 0;
+  // heap_bytes_allocated() at the end of the last slice
+  u64 allocated = 0;
+};
+
+struct GarbageCollector {
+  std::ofstream *log_file = nullptr;
+  // collect the young generation on its own, see --gc-full
+  bool generational = true;
+  // longest the collector should stop the program for, see --gc-pause-ms
+  double pause_budget_ms = GC_DEFAULT_PAUSE_MS;
+  GCPhase phase = GCPhase::Idle;
+  // gc_bits of new objects, they're black while marking and old while
+  // sweeping
+  u8 alloc_bits = 0;
+  // objects that are never collected
+  std::vector<Object *> pinned;
+  // the pinned objects before this index are old
+  size_t pinned_old = 0;
+  // young objects old ones may refer to
+  std::vector<Object *> remembered;
+  std::vector<GreyObject> mark_stack;
+  u64 nursery_size = 2 * 1024 * 1024;
+  // heap_bytes_allocated() when the collector should run next
+  u64 next_collection = 2 * 1024 * 1024;
+  // size of the old generation after the last collection, a major one
+  // starts once it reaches next_major
+  u64 old_bytes = 0;
+  u64 next_major = GC_MIN_THRESHOLD;
+  MajorCycle major;
+  GCStats stats;
+};
+
+extern GarbageCollector GC;
+
+void init_gc();
+// Keeps the object alive for the rest of the run
+void gc_pin(Object *obj);
+// Greys a white object
+void gc_shade(Object *obj);
+// Greys the constants of compiled code and of the functions it defines,
+// once per major collection. Minor collections find the young constants
+// remembered (see gc_const_barrier).
+void gc_mark_proto(Proto *proto);
+
+inline bool gc_wanted() {
+  return heap_bytes_allocated() >= GC.next_collection;
+}
+
+// Does the collection work that is due: a minor collection or a slice of
+// the major one. env is the environment of the running compiled code, if
+// any; the rest of the roots are found by the collector.
+void gc_step(Object *env = nullptr);
+
+// Pause time in milliseconds that the given share (0-1) of the pauses
+// took at most
+double gc_pause_percentile(double share);
+
+#endif
@@ -0,0 +1,146 @@
+#include "hash_table.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <bit>
+
+#include "objects.hpp"
+
+// Bit i is set for the slots of the group whose control byte is b
+inline u32 group_match(i8 const *group, i8 b) {
+#if defined(__SSE2__)
+  auto ctrl = _mm_loadu_si128((__m128i const *)group);
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(b)));
+#else
+  u32 res = 0;
+  for (u32 i = 0; i < HT_GROUP_SIZE; ++i) res |= (u32)(group[i] == b) << i;
+  return res;
+#endif
+}
+
+// Bit i is set for the empty or deleted slots of the group, the only
+// control bytes with the sign bit set
+inline u32 group_match_free(i8 const *group) {
+#if defined(__SSE2__)
+  return _mm_movemask_epi8(_mm_loadu_si128((__m128i const *)group));
+#else
+  u32 res = 0;
+  for (u32 i = 0; i < HT_GROUP_SIZE; ++i) res |= (u32)(group[i] < 0) << i;
+  return res;
+#endif
+}
+
+// Spreads the bits of the hash, numbers hash to themselves
+inline u64 mix_hash(ObjectHash hash) {
+  u64 h = (u64)hash * 0x9e3779b97f4a7c15;
+  return h ^ (h >> 32);
+}
+
+inline i8 control_byte(u64 mixed) { return mixed & 0x7f; }
+
+// Where the probing of a hash starts. Consecutive hashes (the ones of
+// consecutive numbers) start 8 to a group, in runs of 256 over consecutive
+// groups, so that going through a range of numbers goes through the memory
+// in order. The runs themselves start at unrelated groups.
+inline u64 probe_start(ObjectHash hash) {
+  return ((u64)hash >> 3) + mix_hash(hash >> 8);
+}
+
+// At most 7/8 of the slots are filled, so that probing always ends
+inline size_t max_load(size_t capacity) { return capacity - capacity / 8; }
+
+// The groups a hash probes, in order. The steps grow by one group every
+// time, which visits all of them when their number is a power of two.
+struct Probe {
+  size_t mask;
+  size_t group;
+  size_t step = 0;
+
+  Probe(ObjectHash hash, size_t capacity)
+      : mask(capacity / HT_GROUP_SIZE - 1), group(probe_start(hash) & mask) {}
+  size_t offset() const { return group * HT_GROUP_SIZE; }
+  void next() { group = (group + ++step) & mask; }
+};
+
+// The slot of the key, -1 if it's not in the table
+i64 find_slot(HashTable const &table, ObjectHash hash, Object *key) {
+  if (table.size == 0) return -1;
+  u64 mixed = mix_hash(hash);
+  for (Probe probe(hash, ht_capacity(table));; probe.next()) {
+    auto *group = table.ctrl.data() + probe.offset();
+    for (u32 m = group_match(group, control_byte(mixed)); m != 0; m &= m - 1) {
+      size_t i = probe.offset() + std::countr_zero(m);
+      auto &slot = table.slots[i];
+      if (slot.key == key ||
+          (slot.hash == hash && keys_equal_bare(slot.key, key))) {
+        return i;
+      }
+    }
+    if (group_match(group, HT_EMPTY) != 0) return -1;
+  }
+}
+
+// The first empty or deleted slot the hash probes
+size_t free_slot(HashTable const &table, ObjectHash hash) {
+  for (Probe probe(hash, ht_capacity(table));; probe.next()) {
+    auto m = group_match_free(table.ctrl.data() + probe.offset());
+    if (m != 0) return probe.offset() + std::countr_zero(m);
+  }
+}
+
+// Moves the entries to new slots: twice as many when the entries fill
+// half of the load, as many when deleted slots do
+void rehash(HashTable &table) {
+  size_t capacity = std::max((size_t)HT_GROUP_SIZE, ht_capacity(table));
+  if (table.size + 1 > max_load(capacity) / 2) capacity *= 2;
+  auto ctrl = std::move(table.ctrl);
+  auto slots = std::move(table.slots);
+  table.ctrl.assign(capacity, HT_EMPTY);
+  table.slots.assign(capacity, {0, nullptr, nullptr});
+  table.growth_left = max_load(capacity) - table.size;
+  ++table.rehashes;
+  for (size_t i = 0; i < ctrl.size(); ++i) {
+    if (ctrl[i] < 0) continue;
+    auto j = free_slot(table, slots[i].hash);
+    table.ctrl[j] = control_byte(mix_hash(slots[i].hash));
+    table.slots[j] = slots[i];
+  }
+}
+
+Object *ht_find(HashTable const &table, ObjectHash hash, Object *key) {
+  auto i = find_slot(table, hash, key);
+  return i < 0 ? nullptr : table.slots[i].value;
+}
+
+void ht_set(HashTable &table, ObjectHash hash, Object *key, Object *value) {
+  if (auto i = find_slot(table, hash, key); i >= 0) {
+    table.slots[i].value = value;
+    return;
+  }
+  if (table.growth_left == 0) rehash(table);
+  auto i = free_slot(table, hash);
+  if (table.ctrl[i] == HT_EMPTY) --table.growth_left;
+  table.ctrl[i] = control_byte(mix_hash(hash));
+  table.slots[i] = {hash, key, value};
+  ++table.size;
+}
+
+bool ht_remove(HashTable &table, ObjectHash hash, Object *key) {
+  auto i = find_slot(table, hash, key);
+  if (i < 0) return false;
+  // A group only has empty slots if it was never full since the last
+  // rehash, then no probe went past it and the slot can be empty again
+  auto *group = table.ctrl.data() + (i - i % HT_GROUP_SIZE);
+  if (group_match(group, HT_EMPTY) != 0) {
+    table.ctrl[i] = HT_EMPTY;
+    ++table.growth_left;
+  } else {
+    table.ctrl[i] = HT_DELETED;
+  }
+  table.slots[i] = {0, nullptr, nullptr};
+  --table.size;
+  return true;
+}
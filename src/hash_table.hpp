@@ -0,0 +1,68 @@
+#ifndef HASH_TABLE_HPP
+#define HASH_TABLE_HPP
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "types.hpp"
+
+struct Object;
+
+using ObjectHash = i64;
+
+// Open-addressing table of the HashTable objects, laid out like a Swiss
+// table. The slots are split in groups of HT_GROUP_SIZE, and every slot has
+// a control byte: HT_EMPTY, HT_DELETED or, for a full slot, 7 bits of the
+// hash of its key. A lookup compares the control bytes of a whole group at
+// once (with SSE2 where available), then the keys of the matching slots
+// with keys_equal_bare. Groups are probed from the one the hash picks
+// until one has an empty slot. Keys and values are stored inline, with the
+// hash of the key.
+
+const u32 HT_GROUP_SIZE = 16;
+const i8 HT_EMPTY = -128;
+const i8 HT_DELETED = -2;
+
+struct HashTableSlot {
+  ObjectHash hash;
+  Object *key;
+  Object *value;
+};
+
+struct HashTable {
+  // one byte per slot, the slots are full where it's positive
+  std::vector<i8> ctrl;
+  std::vector<HashTableSlot> slots;
+  size_t size = 0;
+  // slots that can still be filled before the table is rehashed, deleted
+  // slots count as filled
+  size_t growth_left = 0;
+  // rehashes so far, the entries move on every one
+  u64 rehashes = 0;
+};
+
+// The value of the key, nullptr if it's not in the table
+Object *ht_find(HashTable const &table, ObjectHash hash, Object *key);
+// Sets the value of the key
+void ht_set(HashTable &table, ObjectHash hash, Object *key, Object *value);
+// Returns whether the key was in the table
+bool ht_remove(HashTable &table, ObjectHash hash, Object *key);
+
+inline size_t ht_capacity(HashTable const &table) {
+  return table.slots.size();
+}
+
+inline bool ht_slot_full(HashTable const &table, size_t i) {
+  return table.ctrl[i] >= 0;
+}
+
+// Calls f with the key and the value of every entry
+template <typename F>
+void ht_for_each(HashTable const &table, F f) {
+  for (size_t i = 0; i < ht_capacity(table); ++i) {
+    if (ht_slot_full(table, i)) f(table.slots[i].key, table.slots[i].value);
+  }
+}
+
+#endif
@@ -0,0 +1,83 @@
+#include "heap.hpp"
+
+#include <stdlib.h>
+
+#include <algorithm>
+
+#include "util.hpp"
+
+Heap HEAP;
+
+HeapPage *new_heap_page(u32 size_class) {
+  auto *page = (HeapPage *)aligned_alloc(HEAP_PAGE_SIZE, HEAP_PAGE_SIZE);
+  assert_stmt(page != nullptr, "Out of memory");
+  page->free = nullptr;
+  page->size_class = size_class;
+  page->cell_size = HEAP_SIZE_CLASSES[size_class];
+  page->ncells = (HEAP_PAGE_SIZE - HEAP_PAGE_HEADER) / page->cell_size;
+  // the cells are allocated after any sweep in progress started
+  page->sweep_epoch = HEAP.sweep_epoch;
+  auto &cls = HEAP.classes[size_class];
+  page->next = cls.pages;
+  cls.pages = page;
+  ++HEAP.stats.pages;
+  return page;
+}
+
+// The current page of the class ran out of cells: continue with a page that
+// has free cells, or a new one
+void *heap_alloc_slow(u32 size_class) {
+  assert_stmt(size_class < HEAP_NUM_SIZE_CLASSES,
+              "Heap cells are at most HEAP_MAX_CELL_SIZE bytes");
+  auto &cls = HEAP.classes[size_class];
+  cls.current = nullptr;
+  if (cls.with_free != nullptr) {
+    auto *page = cls.with_free;
+    cls.with_free = page->next_with_free;
+    page->young = true;
+    cls.current = page;
+    cls.free = page->free->next;
+    auto *res = page->free;
+    page->free = nullptr;
+    cls.bump = cls.bump_end = nullptr;
+    return res;
+  }
+  auto *page = new_heap_page(size_class);
+  page->young = true;
+  cls.current = page;
+  char *cells = (char *)page + HEAP_PAGE_HEADER;
+  cls.bump = cells + page->cell_size;
+  cls.bump_end = cells + page->ncells * page->cell_size;
+  return cells;
+}
+
+void heap_sweep_begin(bool young_only) {
+  ++HEAP.sweep_epoch;
+  HEAP.sweep_young_only = young_only;
+  for (auto &cls : HEAP.classes) {
+    // hand the current page back: the untouched cells and the ones taken
+    // over become free cells again
+    for (char *cell = cls.bump; cell < cls.bump_end;
+         cell += cls.current->cell_size) {
+      ((FreeCell *)cell)->marker = HEAP_FREE_CELL;
+    }
+    cls.current = nullptr;
+    cls.bump = cls.bump_end = nullptr;
+    cls.free = nullptr;
+    // the pages left unswept only get free cells back once swept
+    if (!young_only) cls.with_free = nullptr;
+    cls.sweep_link = &cls.pages;
+  }
+}
+
+void heap_release_page(HeapPage *page) {
+  free(page);
+  --HEAP.stats.pages;
+}
+
+u32 heap_fragmentation() {
+  u64 total = HEAP.stats.pages * HEAP_PAGE_SIZE;
+  if (total == 0) return 0;
+  i64 free_share = 100 - (i64)(heap_bytes_in_use() * 100 / total);
+  return (u32)std::clamp<i64>(free_share, 0, 100);
+}
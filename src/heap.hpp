@@ -0,0 +1,225 @@
+#ifndef HEAP_HPP
+#define HEAP_HPP
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "types.hpp"
+
+// Object heap. Cells of the same size are kept together in aligned pages,
+// one list of pages per size class. New cells are bump-allocated from the
+// untouched tail of the current page of their class (the nursery), the ones
+// freed by heap_sweep are reused through the free list of their page.
+//
+// Cells carry no allocator bookkeeping besides their first byte: heap users
+// must never store HEAP_FREE_CELL there in a live cell (Object keeps its type
+// there). A free cell keeps the link to the next free one after the first
+// word.
+
+const size_t HEAP_PAGE_SIZE = 64 * 1024;
+const u8 HEAP_FREE_CELL = 0xFF;
+const u32 HEAP_SIZE_CLASSES[] = {16, 24, 32, 48, 64, 96, 128, 256};
+const u32 HEAP_NUM_SIZE_CLASSES =
+    sizeof(HEAP_SIZE_CLASSES) / sizeof(HEAP_SIZE_CLASSES[0]);
+const size_t HEAP_MAX_CELL_SIZE = 256;
+
+struct FreeCell {
+  u8 marker;
+  FreeCell *next;
+};
+
+struct HeapPage {
+  // next page of the same size class
+  HeapPage *next;
+  // free cells the allocator hasn't taken yet
+  FreeCell *free;
+  // next page of the same size class with free cells
+  HeapPage *next_with_free;
+  u32 size_class;
+  u32 cell_size;
+  u32 ncells;
+  // allocated from since the last sweep
+  bool young;
+  // sweep the page was last swept (or created) during
+  u32 sweep_epoch;
+};
+
+// Cells start at the first multiple of 16 after the page header
+const size_t HEAP_PAGE_HEADER = (sizeof(HeapPage) + 15) & ~(size_t)15;
+
+struct SizeClass {
+  HeapPage *pages = nullptr;
+  // pages with free cells, the ones with a non-empty free list
+  HeapPage *with_free = nullptr;
+  HeapPage *current = nullptr;
+  // untouched part of the current page
+  char *bump = nullptr;
+  char *bump_end = nullptr;
+  // free cells taken over from the current page
+  FreeCell *free = nullptr;
+  // link to the next page to sweep
+  HeapPage **sweep_link = nullptr;
+};
+
+struct HeapStats {
+  // Totals since the start
+  u64 bytes_allocated = 0;
+  u64 objects_allocated = 0;
+  u64 bytes_freed = 0;
+  u64 pages = 0;
+  // What objects own outside of the pages (numeric vector elements, bignum
+  // limbs), see heap_external_alloc
+  u64 external_allocated = 0;
+  u64 external_freed = 0;
+};
+
+struct Heap {
+  SizeClass classes[HEAP_NUM_SIZE_CLASSES];
+  HeapStats stats;
+  u32 sweep_epoch = 0;
+  bool sweep_young_only = false;
+};
+
+extern Heap HEAP;
+
+void *heap_alloc_slow(u32 size_class);
+
+inline u32 heap_size_class(size_t size) {
+  for (u32 i = 0; i < HEAP_NUM_SIZE_CLASSES; ++i) {
+    if (size <= HEAP_SIZE_CLASSES[i]) return i;
+  }
+  return HEAP_NUM_SIZE_CLASSES;
+}
+
+inline HeapPage *heap_page_of(void const *cell) {
+  return (HeapPage *)((uintptr_t)cell & ~(uintptr_t)(HEAP_PAGE_SIZE - 1));
+}
+
+inline bool heap_cell_is_free(void const *cell) {
+  return *(u8 const *)cell == HEAP_FREE_CELL;
+}
+
+// Allocates a cell of at least size bytes (up to HEAP_MAX_CELL_SIZE), 8-byte
+// aligned
+inline void *heap_alloc(size_t size) {
+  u32 sc = heap_size_class(size);
+  auto &cls = HEAP.classes[sc];
+  u32 cell_size = HEAP_SIZE_CLASSES[sc];
+  void *res;
+  if (cls.free != nullptr) {
+    res = cls.free;
+    cls.free = cls.free->next;
+  } else if (cls.bump + cell_size <= cls.bump_end) {
+    res = cls.bump;
+    cls.bump += cell_size;
+  } else {
+    res = heap_alloc_slow(sc);
+  }
+  HEAP.stats.bytes_allocated += cell_size;
+  HEAP.stats.objects_allocated += 1;
+  return res;
+}
+
+void heap_release_page(HeapPage *page);
+
+// Starts a sweep of the pages allocated so far, done by heap_sweep_some.
+// Meanwhile the allocator only reuses the pages already swept. With
+// young_only, only the pages allocated from since the last sweep are swept
+// and the empty ones are kept for reuse.
+void heap_sweep_begin(bool young_only);
+
+// Continues the sweep while keep_going() returns true, checked after every
+// page. Calls dead on every allocated cell and frees the ones it returns
+// true for, rebuilding the free lists of the pages and releasing the empty
+// ones. Counts the freed cells in freed, returns whether the sweep is done.
+template <typename F, typename G>
+bool heap_sweep_some(F dead, G keep_going, u64 &freed) {
+  bool young_only = HEAP.sweep_young_only;
+  for (auto &cls : HEAP.classes) {
+    HeapPage **&link = cls.sweep_link;
+    while (*link != nullptr) {
+      auto *page = *link;
+      if (page->sweep_epoch == HEAP.sweep_epoch ||
+          (young_only && !page->young)) {
+        link = &page->next;
+        continue;
+      }
+      page->sweep_epoch = HEAP.sweep_epoch;
+      page->young = false;
+      page->free = nullptr;
+      u32 live = 0;
+      char *cell = (char *)page + HEAP_PAGE_HEADER;
+      for (u32 i = 0; i < page->ncells; ++i, cell += page->cell_size) {
+        auto *fc = (FreeCell *)cell;
+        if (!heap_cell_is_free(cell)) {
+          if (!dead((void *)cell)) {
+            ++live;
+            continue;
+          }
+          fc->marker = HEAP_FREE_CELL;
+          HEAP.stats.bytes_freed += page->cell_size;
+          ++freed;
+        }
+        fc->next = page->free;
+        page->free = fc;
+      }
+      if (live == 0 && !young_only) {
+        *link = page->next;
+        heap_release_page(page);
+      } else {
+        if (page->free != nullptr) {
+          page->next_with_free = cls.with_free;
+          cls.with_free = page;
+        }
+        link = &page->next;
+      }
+      if (!keep_going()) return false;
+    }
+  }
+  return true;
+}
+
+// Sweeps the heap at once, see heap_sweep_begin
+template <typename F>
+u64 heap_sweep(F dead, bool young_only = false) {
+  u64 freed = 0;
+  heap_sweep_begin(young_only);
+  heap_sweep_some(dead, []() { return true; }, freed);
+  return freed;
+}
+
+// Bytes in use by the cells of the pages
+inline u64 heap_bytes_in_use() {
+  return HEAP.stats.bytes_allocated - HEAP.stats.bytes_freed;
+}
+
+// Big arrays that objects own outside of the pages are counted apart from
+// the cells: they bring the next collection closer (see gc_wanted) but take
+// no page memory
+inline void heap_external_alloc(size_t bytes) {
+  HEAP.stats.external_allocated += bytes;
+}
+
+inline void heap_external_free(size_t bytes) {
+  HEAP.stats.external_freed += bytes;
+}
+
+inline u64 heap_external_bytes() {
+  return HEAP.stats.external_allocated - HEAP.stats.external_freed;
+}
+
+// Bytes allocated since the start, in the pages and outside, that the
+// collector is paced by
+inline u64 heap_bytes_allocated() {
+  return HEAP.stats.bytes_allocated + HEAP.stats.external_allocated;
+}
+
+// Bytes in use in the pages and outside
+inline u64 heap_live_bytes() {
+  return heap_bytes_in_use() + heap_external_bytes();
+}
+
+// Share of the page memory not taken by live cells, in percent
+u32 heap_fragmentation();
+
+#endif
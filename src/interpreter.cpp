@@ -16,14 +16,24 @@
 #include <string>
 #include <string_view>
 #include <thread>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "errors.hpp"
+#include "eval_cache.hpp"
+#include "gc.hpp"
+#include "memo.hpp"
+#include "num_vector.hpp"
+#include "numbers.hpp"
 #include "objects.hpp"
+#include "optimizer.hpp"
+#include "persistent_map.hpp"
 #include "platform/platform.hpp"
+#include "structs.hpp"
 #include "util.hpp"
+#include "vm.hpp"
 
 using fmt::format;
 using std::chrono::duration;
@@ -34,8 +44,9 @@ using std::filesystem::path;
 
 path STDLIB_PATH = "./stdlib";
 
-InterpreterState IS;
-GarbageCollector GC;
+// read from before any file is loaded
+ReaderContext toplevel_reader;
+InterpreterState IS{&toplevel_reader};
 
 inline bool can_start_a_symbol(char ch) {
   return isalpha(ch) || ch == '+' || ch == '-' || ch == '=' || ch == '-' ||
@@ -48,37 +59,93 @@ inline bool can_be_a_part_of_symbol(char ch) {
 }
 
 inline char next_char() {
-  ++IS.text_pos;
-  return IS.text[IS.text_pos];
+  ++IS.reader->text_pos;
+  return IS.reader->text[IS.reader->text_pos];
 }
 
-inline char get_char() { return IS.text[IS.text_pos]; }
+inline char get_char() { return IS.reader->text[IS.reader->text_pos]; }
+
+// The character k after the current one, '\0' past the end
+inline char peek_char(int k = 1) {
+  int pos = IS.reader->text_pos + k;
+  return pos < IS.reader->text_len ? IS.reader->text[pos] : '\0';
+}
 
 inline void skip_char() {
-  ++IS.col;
-  ++IS.text_pos;
+  ++IS.reader->col;
+  ++IS.reader->text_pos;
 }
 
 inline void consume_char(char ch) {
-  ++IS.col;
+  ++IS.reader->col;
   if (get_char() == ch) {
-    ++IS.text_pos;
+    ++IS.reader->text_pos;
     return;
   }
-  error_msg(format("Expected {} but found {}\n", ch, *IS.text));
+  error_msg(format("Expected {} but found {}\n", ch, *IS.reader->text));
+}
+
+// Call sites of the tree-walker cache the function their head symbol
+// resolved to, see resolve_callee. The entries are valid while the symbol
+// is only bound globally and no global binding of a function changed since.
+struct CallSite {
+  SymbolId sym;
+  u64 epoch;
+  Object *callable;
+  // the callable is a built-in taking the arguments of the call
+  bool arity_checked;
+};
+
+std::vector<CallSite> call_sites;
+std::vector<u32> free_call_sites;
+u64 globals_epoch = 0;
+// how many scopes besides the global one bind each symbol
+std::vector<u32> local_bindings;
+
+void release_call_site(u32 call_site) {
+  free_call_sites.push_back(call_site);
+}
+
+inline void count_local_binding(SymbolId key, int delta) {
+  if (key >= local_bindings.size()) local_bindings.resize(key + 1);
+  local_bindings[key] += delta;
+}
+
+inline bool is_bound_locally(SymbolId key) {
+  return key < local_bindings.size() && local_bindings[key] != 0;
+}
+
+// Called before a global binding is changed from old_value (nullptr for a
+// new one) to new_value
+inline void global_binding_changed(Object *old_value, Object *new_value) {
+  bool was_function =
+      old_value != nullptr && obj_type(old_value) == ObjType::Function;
+  if (was_function || obj_type(new_value) == ObjType::Function) {
+    ++globals_epoch;
+  }
+}
+
+// Binds the symbol in the scope, keeping the call sites up to date
+void bind_symbol(SymTable *scope, SymbolId key, Object *value) {
+  auto [it, inserted] = scope->map.try_emplace(key, nullptr);
+  if (scope == IS.globals) {
+    global_binding_changed(it->second, value);
+  } else if (inserted) {
+    count_local_binding(key, 1);
+  }
+  it->second = value;
 }
 
-inline void set_symbol(std::string const &key, Object *value) {
-  inc_ref(value);
-  IS.symtable->map[key] = value;
+void set_symbol(SymbolId key, Object *value) {
+  bind_symbol(IS.symtable, key, value);
 }
 
-Object *get_symbol(std::string &key) {
+Object *get_symbol(SymbolId key) {
   SymTable *ltable = IS.symtable;
   while (true) {
-    bool present = ltable->map.find(key) != ltable->map.end();
-    if (present) {
-      return ltable->map[key];
+    auto it = ltable->map.find(key);
+    if (it != ltable->map.end()) {
+      return it->second;
     }
     // Global table
     if (ltable->prev == nullptr) {
@@ -88,6 +155,15 @@ Object *get_symbol(std::string &key) {
   }
 }
 
+void set_global(SymbolId key, Object *value) {
+  bind_symbol(IS.globals, key, value);
+}
+
+Object *get_global(SymbolId key) {
+  auto it = IS.globals->map.find(key);
+  return it != IS.globals->map.end() ? it->second : nil_obj;
+}
+
 // TODO: Add limit to the depth of the symbol table (to prevent stack overflows)
 void enter_scope() {
   SymTable *new_scope = new SymTable();
@@ -98,20 +174,15 @@ void enter_scope() {
 void enter_scope_with(SymVars vars) {
   SymTable *new_scope = new SymTable();
   new_scope->map = vars;
-  for (auto &var : new_scope->map) {
-    inc_ref(var.second);
-  }
   new_scope->prev = IS.symtable;
   IS.symtable = new_scope;
+  for (auto &var : vars) count_local_binding(var.first, 1);
 }
 
 void exit_scope() {
   assert_stmt(IS.symtable->prev != nullptr, "Trying to exit global scope");
   auto *prev = IS.symtable->prev;
-  // decrease references to all referenced objects in scope
-  for (auto &s : IS.symtable->map) {
-    dec_ref(s.second);
-  }
+  for (auto &var : IS.symtable->map) count_local_binding(var.first, -1);
   delete IS.symtable;
   IS.symtable = prev;
 }
@@ -120,10 +191,10 @@ Object *read_str() {
   auto *svalue = new std::string("");
   consume_char('"');
   char ch = get_char();
-  while (IS.text_pos < IS.text_len) {
+  while (IS.reader->text_pos < IS.reader->text_len) {
     if (ch == '\\') {
       ch = next_char();
-      if (IS.text_pos >= IS.text_len) {
+      if (IS.reader->text_pos >= IS.reader->text_len) {
         eof_error();
         delete svalue;
         return nil_obj;
@@ -165,27 +236,39 @@ Object *read_str() {
 }
 
 Object *read_sym() {
-  auto *svalue = new std::string("");
+  int start = IS.reader->text_pos;
   char ch = get_char();
-  while (IS.text_pos < IS.text_len && can_be_a_part_of_symbol(ch)) {
-    svalue->push_back(ch);
+  while (IS.reader->text_pos < IS.reader->text_len &&
+         can_be_a_part_of_symbol(ch)) {
     ch = next_char();
   }
-  return create_sym_obj(svalue);
+  return intern_sym_obj(
+      std::string_view(IS.reader->text + start, IS.reader->text_pos - start));
 }
 
+// Integers, with a point and decimals or an exponent for floats
 Object *read_num() {
-  char ch = get_char();
-  static char buf[1024];
-  int buf_len = 0;
-  while (IS.text_pos < IS.text_len && isdigit(ch)) {
-    buf[buf_len] = ch;
-    ch = next_char();
-    ++buf_len;
+  int start = IS.reader->text_pos;
+  auto skip_digits = []() {
+    while (IS.reader->text_pos < IS.reader->text_len && isdigit(get_char())) {
+      next_char();
+    }
+  };
+  if (get_char() == '-') next_char();
+  skip_digits();
+  if (get_char() == '.' && isdigit(peek_char())) {
+    next_char();
+    skip_digits();
+  }
+  if (get_char() == 'e' || get_char() == 'E') {
+    int sign = peek_char() == '-' || peek_char() == '+';
+    if (isdigit(peek_char(1 + sign))) {
+      IS.reader->text_pos += 1 + sign;
+      skip_digits();
+    }
   }
-  buf[buf_len] = '\0';
-  int v = std::stoi(buf);
-  return create_num_obj(v);
+  std::string_view text(IS.reader->text + start, IS.reader->text_pos - start);
+  return parse_number(text);
 }
 
 Object *read_expr();
@@ -197,7 +280,7 @@ Object *read_list(bool literal = false) {
   }
   consume_char('(');
   while (get_char() != ')') {
-    if (IS.text_pos >= IS.text_len) {
+    if (IS.reader->text_pos >= IS.reader->text_len) {
       eof_error();
       return nullptr;
     }
@@ -210,7 +293,7 @@ Object *read_list(bool literal = false) {
 
 Object *read_expr() {
   char ch = get_char();
-  if (IS.text_pos >= IS.text_len) return nil_obj;
+  if (IS.reader->text_pos >= IS.reader->text_len) return nil_obj;
   switch (ch) {
     case ' ': {
       skip_char();
@@ -220,8 +303,8 @@ Object *read_expr() {
     case '\r': {
       // TODO: Count the skipped lines
       skip_char();
-      ++IS.line;
-      IS.col = 0;
+      ++IS.reader->line;
+      IS.reader->col = 0;
       return read_expr();
     } break;
     case ';': {
@@ -252,7 +335,7 @@ Object *read_expr() {
       return nil_obj;
     } break;
     default: {
-      if (isdigit(ch)) {
+      if (isdigit(ch) || (ch == '-' && isdigit(peek_char()))) {
         return read_num();
       }
       if (can_start_a_symbol(ch)) {
@@ -268,18 +351,18 @@ Object *read_expr() {
 Object *eval_expr(Object *expr);
 
 Object *add_objects(Object *expr) {
-  auto *l = expr->val.l_value;
-  int elems_len = l->size();
+  auto l = list_members(expr);
+  int elems_len = l.size();
   int args_len = elems_len - 1;
   if (args_len < 2) {
     printf("Add (+) operator can't have less than two arguments\n");
     return nil_obj;
   }
-  Object *add_res = eval_expr(l->at(1));
+  Object *add_res = eval_expr(l[1]);
   int arg_idx = 2;
   // @PERFORMANCE: Optimize for concatenation of multiple strings
   while (arg_idx < elems_len) {
-    auto *operand = eval_expr(l->at(arg_idx));
+    auto *operand = eval_expr(l[arg_idx]);
     // actually add objects
     add_res = add_two_objects(add_res, operand);
     ++arg_idx;
@@ -288,25 +371,42 @@ Object *add_objects(Object *expr) {
 }
 
 Object *sub_objects(Object *expr) {
-  auto *l = expr->val.l_value;
-  int elems_len = l->size();
+  auto l = list_members(expr);
+  int elems_len = l.size();
   int args_len = elems_len - 1;
   if (args_len < 2) {
     printf("Subtraction (+) operator can't have less than two arguments\n");
     return nil_obj;
   }
-  Object *res = eval_expr(l->at(1));
+  Object *res = eval_expr(l[1]);
   int arg_idx = 2;
   while (arg_idx < elems_len) {
-    auto *operand = eval_expr(l->at(arg_idx));
+    auto *operand = eval_expr(l[arg_idx]);
     res = sub_two_objects(res, operand);
     ++arg_idx;
   }
   return res;
 }
 
-static size_t call_stack_size = 0;
-const size_t MAX_STACK_SIZE = 256;
+size_t call_stack_size = 0;
+
+// Runs the body of a tree-walker function with its arguments bound
+Object *run_function_body(Object *fobj, SymVars const &locals) {
+  auto bodyl = list_members(fobj->val.f_value.funbody);
+  int body_length = bodyl.size();
+  // Starting from 1 because 1st index is function name
+  int body_expr_idx = 2;
+  Object *last_evaluated = nil_obj;
+  ++call_stack_size;
+  enter_scope_with(locals);
+  while (body_expr_idx < body_length) {
+    last_evaluated = eval_expr(bodyl[body_expr_idx]);
+    ++body_expr_idx;
+  }
+  exit_scope();
+  --call_stack_size;
+  return last_evaluated;
+}
 
 Object *call_function(Object *fobj, Object *args_list) {
   if (call_stack_size > MAX_STACK_SIZE) {
@@ -315,16 +415,16 @@ Object *call_function(Object *fobj, Object *args_list) {
   }
 
   // Set arguments in the local scope
-  auto *arglistl = fobj->val.f_value.funargs->val.l_value;
-  auto *provided_arglistl = args_list->val.l_value;
-  bool is_lambda = fobj->flags & OF_LAMBDA;
+  auto arglistl = list_members(fobj->val.f_value.funargs);
+  auto provided_arglistl = list_members(args_list);
+  bool is_lambda = obj_flags(fobj) & OF_LAMBDA;
   // Lambda only have arguments int their arglist, while defuns
   // also have a function name as a first parameter. So we skip that
   // if needed.
   int starting_arg_idx = is_lambda ? 0 : 1;
 
   SymVars locals;
-  auto set_symbol_local = [&](std::string &symname, Object *value) -> bool {
+  auto set_symbol_local = [&](SymbolId symname, Object *value) -> bool {
     // evaluate all arguments before calling
     // TODO: Maybe implement lazy evaluation for arguments with context binding?
     auto *evaluated = eval_expr(value);
@@ -335,15 +435,15 @@ Object *call_function(Object *fobj, Object *args_list) {
   // Because calling function still means that the first element
   // of the list is either a (lambda ()) or a function name (callthis a b c)
   int provided_arg_offset = is_lambda ? 1 : 0;
-  for (size_t arg_idx = starting_arg_idx; arg_idx < arglistl->size();
+  for (size_t arg_idx = starting_arg_idx; arg_idx < arglistl.size();
        ++arg_idx) {
-    auto *arg = arglistl->at(arg_idx);
-    auto *local_arg_name = arg->val.s_value;
+    auto *arg = arglistl[arg_idx];
+    auto local_arg_name = sym_id(arg);
     if (arg == dot_obj) {
       // we've reached the end of the usual argument list
       // now variadic arguments start
       // so skip this dot, parse the variadic list arg name, and exit
-      if (arg_idx != (arglistl->size() - 2)) {
+      if (arg_idx != (arglistl.size() - 2)) {
         // if the dot is not on the pre-last position, print out an error
         // message
         printf(
@@ -353,16 +453,16 @@ Object *call_function(Object *fobj, Object *args_list) {
         return nil_obj;
       }
       // read all arguments into a list and bind it to the local scope
-      auto *varg = arglistl->at(arg_idx + 1);
+      auto *varg = arglistl[arg_idx + 1];
       auto *varg_lobj = create_data_list_obj();
       for (auto provided_arg_idx = arg_idx;
-           provided_arg_idx < provided_arglistl->size(); ++provided_arg_idx) {
-        auto *provided_arg = provided_arglistl->at(provided_arg_idx);
+           provided_arg_idx < provided_arglistl.size(); ++provided_arg_idx) {
+        auto *provided_arg = provided_arglistl[provided_arg_idx];
         // user provided a dot argument, which means that a list containing
         // all the rest of variadic arguments must follow
         if (provided_arg == dot_obj) {
           // the dot must be on the pre-last position
-          if (provided_arg_idx != provided_arglistl->size() - 2) {
+          if (provided_arg_idx != provided_arglistl.size() - 2) {
             auto *fn = fun_name(fobj);
             error_msg(format(
                 "Error while calling {}: dot notation on the caller side "
@@ -373,8 +473,8 @@ Object *call_function(Object *fobj, Object *args_list) {
           }
           // expand the rest
           auto *provided_variadic_list =
-              eval_expr(provided_arglistl->at(provided_arg_idx + 1));
-          if (provided_variadic_list->type != ObjType::List) {
+              eval_expr(provided_arglistl[provided_arg_idx + 1]);
+          if (obj_type(provided_variadic_list) != ObjType::List) {
             error_msg(
                 "dot operator on caller side should always be "
                 "followed by a list argument");
@@ -390,81 +490,168 @@ Object *call_function(Object *fobj, Object *args_list) {
         }
         list_append_inplace(varg_lobj, provided_arg);
       }
-      set_symbol_local(*varg->val.s_value, varg_lobj);
+      set_symbol_local(sym_id(varg), varg_lobj);
       break;
     }
-    if (arg_idx >= provided_arglistl->size()) {
+    if (arg_idx >= provided_arglistl.size()) {
       // Reached the end of the user-provided argument list, just
       // fill int nils for the remaining arguments
-      set_symbol_local(*local_arg_name, nil_obj);
+      set_symbol_local(local_arg_name, nil_obj);
     } else {
       int provided_arg_idx = provided_arg_offset + arg_idx;
-      auto *provided_arg = provided_arglistl->at(provided_arg_idx);
-      set_symbol_local(*local_arg_name, provided_arg);
+      auto *provided_arg = provided_arglistl[provided_arg_idx];
+      set_symbol_local(local_arg_name, provided_arg);
     }
   }
-  auto *bodyl = fobj->val.f_value.funbody->val.l_value;
-  int body_length = bodyl->size();
-  // Starting from 1 because 1st index is function name
-  int body_expr_idx = 2;
-  Object *last_evaluated = nil_obj;
-  ++call_stack_size;
-  enter_scope_with(locals);
-  while (body_expr_idx < body_length) {
-    if (last_evaluated != nil_obj) {
-      dec_ref(last_evaluated);
+  return run_function_body(fobj, locals);
+}
+
+Object *apply_function(Object *fobj, Object **args, u32 nargs) {
+  if (call_stack_size > MAX_STACK_SIZE) {
+    error_msg("Max call stack size reached");
+    return nil_obj;
+  }
+  auto arglistl = list_members(fobj->val.f_value.funargs);
+  // defuns have the function name first
+  size_t arg_idx = (obj_flags(fobj) & OF_LAMBDA) ? 0 : 1;
+  SymVars locals;
+  for (u32 provided_idx = 0; arg_idx < arglistl.size();
+       ++arg_idx, ++provided_idx) {
+    auto *arg = arglistl[arg_idx];
+    if (arg == dot_obj) {
+      if (arg_idx != arglistl.size() - 2) {
+        printf(
+            "apply (.) operator in function definition incorrectly placed. "
+            "It should be at the pre-last position, followed by a vararg "
+            "list argument name\n");
+        return nil_obj;
+      }
+      auto *varg_lobj = create_data_list_obj();
+      for (; provided_idx < nargs; ++provided_idx) {
+        list_append_inplace(varg_lobj, args[provided_idx]);
+      }
+      locals[sym_id(arglistl[arg_idx + 1])] = varg_lobj;
+      break;
     }
-    last_evaluated = eval_expr(bodyl->at(body_expr_idx));
-    if (last_evaluated != nil_obj) {
-      inc_ref(last_evaluated);
+    locals[sym_id(arg)] = provided_idx < nargs ? args[provided_idx] : nil_obj;
+  }
+  return run_function_body(fobj, locals);
+}
+
+Object *apply_callable(Object *fobj, Object **args, u32 nargs) {
+  bool tree_walked = obj_type(fobj) == ObjType::Function &&
+                     !(obj_flags(fobj) &
+                       (OF_BUILTIN | OF_COMPILED | OF_MEMOIZED | OF_STRUCT_OP));
+  if (tree_walked) return apply_function(fobj, args, nargs);
+  return vm_apply(fobj, args, nargs);
+}
+
+bool is_callable(Object *obj) { return obj_type(obj) == ObjType::Function; }
+
+// Evaluates the arguments of a call (everything after the operator),
+// expanding a trailing ". list" into separate arguments
+bool eval_call_args(Object *expr, std::vector<Object *> &args) {
+  auto l = list_members(expr);
+  for (size_t i = 1; i < l.size(); ++i) {
+    auto *arg = l[i];
+    if (arg == dot_obj && i == l.size() - 2) {
+      auto *to_spread = eval_expr(l[i + 1]);
+      if (!is_list(to_spread)) {
+        error_msg(
+            "dot operator on caller side should always be "
+            "followed by a list argument");
+        return false;
+      }
+      for (auto *item : list_members(to_spread)) {
+        args.push_back(item);
+      }
+      break;
     }
-    ++body_expr_idx;
+    args.push_back(eval_expr(arg));
   }
-  exit_scope();
-  --call_stack_size;
-  return last_evaluated;
+  return true;
 }
 
-bool is_callable(Object *obj) { return obj->type == ObjType::Function; }
+// Evaluates the head symbol of a call through the cache of the call site.
+// Sets arity_checked if the callable is a built-in known to take the
+// arguments of the call.
+Object *resolve_callee(Object *call, Object *head, bool &arity_checked) {
+  auto sym = sym_id(head);
+  if (is_bound_locally(sym)) return eval_expr(head);
+  if (call->call_site != 0) {
+    auto &site = call_sites[call->call_site - 1];
+    if (site.sym == sym && site.epoch == globals_epoch) {
+      arity_checked = site.arity_checked;
+      return site.callable;
+    }
+  }
+  auto *callable = eval_expr(head);
+  if (!is_callable(callable)) return callable;
+  if (call->call_site == 0) {
+    if (free_call_sites.empty()) {
+      call_sites.emplace_back();
+      call->call_site = call_sites.size();
+    } else {
+      call->call_site = free_call_sites.back();
+      free_call_sites.pop_back();
+    }
+  }
+  // calls spreading a list can take any number of arguments
+  auto l = list_members(call);
+  bool spread = l.size() >= 3 && l[l.size() - 2] == dot_obj;
+  if ((obj_flags(callable) & (OF_BUILTIN | OF_SPECIAL)) == OF_BUILTIN &&
+      !spread) {
+    arity_checked =
+        builtin_accepts(callable->val.bf_value.spec, l.size() - 1);
+  }
+  call_sites[call->call_site - 1] = {sym, globals_epoch, callable,
+                                     arity_checked};
+  return callable;
+}
 
 Object *eval_expr(Object *expr) {
-  if (expr->flags & OF_EVALUATED) {
+  if (obj_flags(expr) & OF_EVALUATED) {
     return expr;
   }
-  switch (expr->type) {
+  switch (obj_type(expr)) {
     case ObjType::Symbol: {
       // Look up value of the symbol in the symbol table
-      auto *syms = expr->val.s_value;
-      auto *res = get_symbol(*syms);
+      auto sym = sym_id(expr);
+      auto *res = get_symbol(sym);
       bool present_in_symtable = res != nullptr;
       if (!present_in_symtable) {
-        printf("Symbol not found: \"%s\"\n", syms->data());
+        printf("Symbol not found: \"%s\"\n", sym_name(expr).data());
         return nil_obj;
       }
       // If object is not yet evaluated
-      if (!(res->flags & OF_EVALUATED)) {
+      if (!(obj_flags(res) & OF_EVALUATED)) {
         // Evaluate & save in the symbol table
         res = eval_expr(res);
-        res->flags |= OF_EVALUATED;
-        set_symbol(*syms, res);
+        if (is_heap_obj(res)) res->flags |= OF_EVALUATED;
+        set_symbol(sym, res);
       }
       return res;
     } break;
     case ObjType::List: {
-      if (expr->flags & OF_LIST_LITERAL) {
-        auto *items = list_members(expr);
-        for (size_t i = 0; i < items->size(); ++i) {
+      if (obj_flags(expr) & OF_LIST_LITERAL) {
+        auto items = list_members(expr);
+        for (size_t i = 0; i < items.size(); ++i) {
           // do we need to evaluate here?
-          (*items)[i] = eval_expr(items->at(i));
+          auto *item = eval_expr(items[i]);
+          gc_write_barrier(expr, item);
+          items[i] = item;
         }
         expr->flags |= OF_EVALUATED;
         return expr;
       }
-      auto *l = expr->val.l_value;
-      int elems_len = l->size();
+      auto l = list_members(expr);
+      int elems_len = l.size();
       if (elems_len == 0) return expr;
-      auto *op = l->at(0);
-      auto *callable = eval_expr(op);
+      auto *op = l[0];
+      bool arity_checked = false;
+      auto *callable = obj_type(op) == ObjType::Symbol
+                           ? resolve_callee(expr, op, arity_checked)
+                           : eval_expr(op);
       if (!is_callable(callable)) {
         auto *s = obj_to_string_bare(callable);
         auto *os = obj_to_string_bare(op);
@@ -474,11 +661,24 @@ Object *eval_expr(Object *expr) {
         delete os;
         return nil_obj;
       }
-      bool is_builtin = callable->flags & OF_BUILTIN;
-      if (is_builtin) {
-        // Built-in function, no need to do much
+      if (obj_flags(callable) & OF_SPECIAL) {
+        return callable->val.bf_value.special_handler(expr);
+      }
+      // Built-ins, memoized functions, the functions of structs and the
+      // functions created by the compiler get their arguments evaluated up
+      // front
+      int evaluated = OF_BUILTIN | OF_COMPILED | OF_MEMOIZED | OF_STRUCT_OP;
+      if (obj_flags(callable) & evaluated) {
+        std::vector<Object *> args;
+        if (!eval_call_args(expr, args)) return nil_obj;
+        if (obj_flags(callable) & (OF_COMPILED | OF_MEMOIZED | OF_STRUCT_OP)) {
+          return vm_apply(callable, args.data(), args.size());
+        }
+        if (!arity_checked && !check_builtin_arity(callable, args.size())) {
+          return nil_obj;
+        }
         auto *bhandler = callable->val.bf_value.builtin_handler;
-        return bhandler(expr);
+        return bhandler(args.data(), args.size());
       }
       // User-defined function
       return call_function(callable, expr);
@@ -491,75 +691,161 @@ Object *eval_expr(Object *expr) {
   }
 }
 
+// files being loaded, imports nest
+u32 load_depth = 0;
+
 bool load_file(path file_to_read) {
   assert_stmt(IS.running, "");
   auto s = read_whole_file_into_memory(file_to_read.c_str());
-  IS.text = s.c_str();
-  IS.file_name = file_to_read.c_str();
-  IS.line = 1;
-  IS.col = 0;
-  if (IS.text == nullptr) {
+  ReaderContext reader{.text = s.c_str(),
+                       .file_name = file_to_read.c_str()};
+  ReaderScope scope(reader);
+  if (reader.text == nullptr) {
     printf("Couldn't load file at %s, skipping\n", file_to_read.c_str());
     IS.running = false;
     return false;
   }
-  IS.text_len = strlen(IS.text);
-  IS.text_pos = 0;
-  while (IS.text_pos < IS.text_len) {
+  reader.text_len = strlen(reader.text);
+  ++load_depth;
+  while (reader.text_pos < reader.text_len) {
     auto *e = read_expr();
-    eval_expr(e);
+    eval_toplevel(e);
+    // nothing but the globals is left between the forms of the main file
+    if (load_depth == 1 && gc_wanted()) gc_step();
   }
+  --load_depth;
   return true;
 }
 
-void gc_task() {
-  GC.log_file =
-      new std::ofstream(GC_LOG_FILE, std::ios_base::app | std::ios_base::ate);
-  using std::chrono::duration;
-  using std::chrono::duration_cast;
-  using std::chrono::high_resolution_clock;
-  using std::chrono::milliseconds;
-  // auto &gc_out = GC.log_file;
-  auto &gc_out = *GC.log_file;
-  gc_out << "Initializing GC..." << std::endl;
-  while (IS.running) {
-    gc_out << "Cleaning up... ";
-    auto start_time = high_resolution_clock::now();
-    u32 objects_total = 0;
-    u32 objects_deleted = 0;
-    // do gc
-    for (auto it = IS.objects_pool.begin(); it != IS.objects_pool.end(); ++it) {
-      auto *curr = *it;
-      const bool persistent = curr->flags & OF_PERSISTENT;
-      if (curr->ref == 0 && !persistent) {
-        auto prev_it = it;
-        ++it;
-        IS.objects_pool.erase(prev_it);
-        delete_obj(curr);
-      } else {
-        objects_total += 1;
-      }
+Object *eval_toplevel(Object *expr) {
+  if (IS.fold_constants) expr = fold_constants(expr);
+  if (IS.tree_walk) return eval_expr(expr);
+  return vm_eval(expr);
+}
+
+bool expect_arg_type(Object **args, std::string const &name, u32 k,
+                     ObjType ot) {
+  Object *arg = args[k];
+  if (obj_type(arg) != ot) {
+    error_msg(format("\"{}\" expects {}-th argument to be a \"{}\", got \"{}\"",
+                     name, k + 1, obj_type_to_str(ot),
+                     obj_type_to_str(obj_type(arg))));
+    return false;
+  }
+  return true;
+}
+
+// The members of the k-th argument of a list built-in, which take nil for
+// the empty list
+bool expect_list_arg(Object **args, std::string const &name, u32 k,
+                     std::span<Object *> &members) {
+  if (args[k] == nil_obj) {
+    members = {};
+    return true;
+  }
+  if (!expect_arg_type(args, name, k, ObjType::List)) return false;
+  members = list_members(args[k]);
+  return true;
+}
+
+// Both arguments are numeric vectors of the same kind and length
+bool expect_vec_pair(Object **args, std::string const &name) {
+  if (!expect_arg_type(args, name, 0, ObjType::NumVector) ||
+      !expect_arg_type(args, name, 1, ObjType::NumVector)) {
+    return false;
+  }
+  if (vec_kind(args[0]) != vec_kind(args[1]) ||
+      vec_length(args[0]) != vec_length(args[1])) {
+    error_msg(format("\"{}\" expects vectors of the same kind and length",
+                     name));
+    return false;
+  }
+  return true;
+}
+
+// i64 vectors only hold fixnums, the element-wise results past them are
+// errors
+Object *error_vec_overflow(std::string const &name) {
+  error_msg(format("\"{}\": a result doesn't fit an i64 vector element", name));
+  return nil_obj;
+}
+
+// The k-th argument is a value vectors of the kind hold
+bool expect_vec_element_arg(Object **args, std::string const &name, u32 k,
+                            VecKind kind) {
+  if (kind == VecKind::I64) {
+    return expect_arg_type(args, name, k, ObjType::Number);
+  }
+  if (!is_number(args[k])) {
+    error_msg(format("\"{}\" expects {}-th argument to be a number, got \"{}\"",
+                     name, k + 1, obj_type_to_str(obj_type(args[k]))));
+    return false;
+  }
+  return true;
+}
+
+// The vector of the kind with the members of the list, which must be
+// fixnums for i64 vectors and any numbers for f64 ones
+Object *list_to_num_vector(Object **args, std::string const &name,
+                           VecKind kind) {
+  std::span<Object *> items;
+  if (!expect_list_arg(args, name, 0, items)) return nil_obj;
+  for (auto *item : items) {
+    if (!vec_accepts(kind, item)) {
+      error_msg(format("\"{}\" expects a list of {}", name,
+                       kind == VecKind::I64 ? "fixnums" : "numbers"));
+      return nil_obj;
     }
-    auto end_time = high_resolution_clock::now();
-    duration<double, std::milli> ms_double = end_time - start_time;
-    auto running_time = ms_double.count();
-    gc_out << format("deleted {} objects, {} total. Took {} ms",
-                     objects_deleted, objects_total, running_time);
-    gc_out << std::endl;
-    std::this_thread::sleep_for(GC_INTERVAL);
   }
+  auto *res = create_num_vector_obj(kind, items.size());
+  for (size_t i = 0; i < items.size(); ++i) vec_set(res, i, items[i]);
+  return res;
+}
+
+// (make-i64vector size [fill]) and (make-f64vector size [fill])
+Object *make_num_vector(Object **args, u32 nargs, std::string const &name,
+                        VecKind kind) {
+  if (nargs > 2) {
+    error_msg(format("\"{}\" expects at most 2 arguments, {} was given", name,
+                     nargs));
+    return nil_obj;
+  }
+  if (!expect_arg_type(args, name, 0, ObjType::Number) ||
+      (nargs == 2 && !expect_vec_element_arg(args, name, 1, kind))) {
+    return nil_obj;
+  }
+  if (num_value(args[0]) < 0 || num_value(args[0]) > UINT32_MAX) {
+    error_msg(format("\"{}\" expects a size from 0 to {}", name, UINT32_MAX));
+    return nil_obj;
+  }
+  size_t size = num_value(args[0]);
+  auto *res = create_num_vector_obj(kind, size);
+  if (nargs == 2) {
+    for (size_t i = 0; i < size; ++i) vec_set(res, i, args[1]);
+  }
+  return res;
 }
 
-void init_gc() { GC.thread = new std::thread(gc_task); }
+// The index of a vec-ref or vec-set call, -1 if it's out of range
+i64 vec_index_arg(Object **args, std::string const &name) {
+  if (!expect_arg_type(args, name, 0, ObjType::NumVector) ||
+      !expect_arg_type(args, name, 1, ObjType::Number)) {
+    return -1;
+  }
+  auto i = num_value(args[1]);
+  if (i < 0 || (size_t)i >= vec_length(args[0])) {
+    error_msg(format("\"{}\": index {} is out of range for a vector of {}",
+                     name, i, vec_length(args[0])));
+    return -1;
+  }
+  return i;
+}
 
-bool expect_arg_type(Object *expr, std::string const &name, u32 k, ObjType ot) {
-  assert_stmt(
-      list_length(expr) >= k,
-      "Should check for argument list length before calling expect_arg_type");
-  Object *arg = list_index(expr, k);
-  if (arg->type != ot) {
-    error_msg(format("\"{}\" expects {}-th argument to be a \"{}\", got \"{}\"",
-                     name, k, obj_type_to_str(ot), obj_type_to_str(arg->type)));
+bool expect_memo_arg(Object **args, std::string const &name, u32 k) {
+  if (obj_type(args[k]) != ObjType::Function ||
+      !(obj_flags(args[k]) & OF_MEMOIZED)) {
+    error_msg(format("\"{}\" expects {}-th argument to be a memoized function",
+                     name, k + 1));
     return false;
   }
   return true;
@@ -569,12 +855,6 @@ bool expect_arg_type(Object *expr, std::string const &name, u32 k, ObjType ot) {
 // Built-ins
 ////////////////////////////////////////////////////
 
-enum class EA {
-  LEQ,
-  GEQ,
-  EQ,
-};
-
 using ArgCheckFormatter = std::function<std::string(
     std::string const &name, EA mtype, u32 expected, u32 given)>;
 
@@ -601,9 +881,8 @@ std::string default_arg_check_error_formatter(std::string const &name, EA mtype,
 }
 
 bool expect_args_check(
-    Object const *builtin_expr, std::string const &name, EA k, u32 n,
+    u64 num_args_given, std::string const &name, EA k, u32 n,
     ArgCheckFormatter formatter = default_arg_check_error_formatter) {
-  u64 num_args_given = list_length(builtin_expr) - 1;
   bool failed = false;
   switch (k) {
     case EA::GEQ: {
@@ -633,45 +912,87 @@ bool expect_args_check(
   return true;
 }
 
-inline bool check_builtin_n_params(char const *bname, Object const *expr,
-                                   size_t n) {
-  return expect_args_check(expr, bname, EA::EQ, n);
+bool check_arity(BuiltinSpec const *spec, u64 nargs) {
+  if (builtin_accepts(spec, nargs)) return true;
+  error_msg(default_arg_check_error_formatter(spec->name, spec->arity,
+                                              spec->nargs, nargs));
+  return false;
 }
 
-inline bool check_builtin_no_params(char const *bname, Object const *expr) {
-  return check_builtin_n_params(bname, expr, 0);
+bool check_builtin_arity(Object *fobj, u64 nargs) {
+  return check_arity(fobj->val.bf_value.spec, nargs);
 }
 
-#define BUILTIN_DEF_FMT(__sym_name, __param_type, __num_params, __fun, __fmt) \
-  do {                                                                        \
-    auto wrapper = [](Object *expr) -> Object * {                             \
-      if (!expect_args_check(expr, (__sym_name), (__param_type),              \
-                             (__num_params), (__fmt))) {                      \
-        return nil_obj;                                                       \
-      }                                                                       \
-      do {                                                                    \
-        return (__fun)(expr);                                                 \
-      } while (0);                                                            \
-    };                                                                        \
-    auto *fobj = create_builtin_fobj((__sym_name), wrapper);                  \
-    set_symbol((__sym_name), fobj);                                           \
-  } while (0);
+// Built-ins don't check their number of arguments, the callers do (see
+// check_builtin_arity)
+void register_builtin(char const *name, EA arity, u32 nargs,
+                      Builtin handler) {
+  auto *spec = new BuiltinSpec{name, arity, nargs};
+  auto *fobj = create_builtin_fobj(spec, handler);
+  set_symbol(intern(name), fobj);
+}
 
 #define BUILTIN_DEF(__sym_name, __param_type, __num_params, __fun) \
-  BUILTIN_DEF_FMT(__sym_name, __param_type, __num_params, (__fun), \
-                  default_arg_check_error_formatter)
+  register_builtin((__sym_name), (__param_type), (__num_params), (__fun))
+
+template <typename R, typename... A>
+constexpr u32 param_count(R (*)(A...)) {
+  return sizeof...(A);
+}
+
+template <typename L, typename R, typename... A>
+constexpr u32 param_count(R (L::*)(A...) const) {
+  return sizeof...(A);
+}
+
+template <auto F, size_t... I>
+inline Object *call_with_args(Object **args, std::index_sequence<I...>) {
+  return F(args[I]...);
+}
+
+// Registers a built-in taking exactly the parameters of F, a function or a
+// lambda with Object * parameters
+template <auto F>
+void builtin_def(char const *name) {
+  constexpr u32 n = [] {
+    if constexpr (std::is_pointer_v<decltype(F)>) {
+      return param_count(F);
+    } else {
+      return param_count(&decltype(F)::operator());
+    }
+  }();
+  register_builtin(name, EA::EQ, n, [](Object **args, u32 nargs) {
+    return call_with_args<F>(args, std::make_index_sequence<n>());
+  });
+}
+
+// Special forms receive the unevaluated expression and evaluate its parts
+// themselves. The compiler turns the ones it knows into bytecode directly.
+#define SPECIAL_FORM_DEF_FMT(__sym_name, __param_type, __num_params, __fun, \
+                             __fmt)                                         \
+  do {                                                                      \
+    auto wrapper = [](Object *expr) -> Object * {                           \
+      if (!expect_args_check(list_length(expr) - 1, (__sym_name),           \
+                             (__param_type), (__num_params), (__fmt))) {    \
+        return nil_obj;                                                     \
+      }                                                                     \
+      do {                                                                  \
+        return (__fun)(expr);                                               \
+      } while (0);                                                          \
+    };                                                                      \
+    auto *spec =                                                            \
+        new BuiltinSpec{(__sym_name), (__param_type), (__num_params)};      \
+    auto *fobj = create_special_fobj(spec, wrapper);                        \
+    set_symbol(intern(__sym_name), fobj);                                   \
+  } while (0);
 
-#define BUILTIN_DEF_BINARY(__name, __handler)       \
-  BUILTIN_DEF(__name, EA::EQ, 2, [](Object *expr) { \
-    auto *l = expr->val.l_value;                    \
-    auto *left_op = eval_expr(l->at(1));            \
-    auto *right_op = eval_expr(l->at(2));           \
-    return __handler(left_op, right_op);            \
-  })
+#define SPECIAL_FORM_DEF(__sym_name, __param_type, __num_params, __fun) \
+  SPECIAL_FORM_DEF_FMT(__sym_name, __param_type, __num_params, (__fun), \
+                       default_arg_check_error_formatter)
 
 std::string curr_module_dir() {
-  assert_stmt(IS.file_name != nullptr, "file name is not initialized");
-  auto fp = path(IS.file_name);
+  assert_stmt(IS.reader->file_name != nullptr, "file name is not initialized");
+  auto fp = path(IS.reader->file_name);
   return fp.parent_path();
 }
 
@@ -696,93 +1017,178 @@ void import_module(std::string *module_name) {
       continue;
     }
     imported_paths.insert(p);
-    InterpreterState saved_state = IS;
     load_file(p);
-    IS = saved_state;
   }
 }
 
+// (dotimes (var count) body...) and (dolist (var list) body...). The loop
+// variable is bound in the current scope and assigned in place on every
+// iteration, so that setq in the body still assigns the variables around
+// the loop as in compiled code. Its previous binding is restored after.
+Object *eval_for_loop(Object *expr, bool over_list) {
+  char const *name = over_list ? "dolist" : "dotimes";
+  auto *spec = list_index(expr, 1);
+  if (!is_list(spec) || list_length(spec) != 2 ||
+      obj_type(list_index(spec, 0)) != ObjType::Symbol) {
+    error_msg(format("{} expects a (variable {}) list first", name,
+                     over_list ? "list" : "count"));
+    return nil_obj;
+  }
+  auto *range = eval_expr(list_index(spec, 1));
+  size_t count;
+  if (over_list) {
+    if (range != nil_obj && !is_list(range)) {
+      error_msg(format("dolist expects a list, got \"{}\"",
+                       obj_type_to_str(obj_type(range))));
+      return nil_obj;
+    }
+    count = range == nil_obj ? 0 : list_length(range);
+  } else {
+    if (obj_type(range) != ObjType::Number) {
+      error_msg(format("dotimes expects a number of times, got \"{}\"",
+                       obj_type_to_str(obj_type(range))));
+      return nil_obj;
+    }
+    count = std::max<i64>(0, num_value(range));
+  }
+  auto var_id = sym_id(list_index(spec, 0));
+  auto *scope = IS.symtable;
+  bool global = scope == IS.globals;
+  auto &vars = scope->map;
+  auto saved = vars.find(var_id);
+  Object *saved_value = saved != vars.end() ? saved->second : nullptr;
+  if (saved_value == nullptr && !global) count_local_binding(var_id, 1);
+  Object *&var = vars[var_id];
+  // the binding is assigned without set_symbol, see bind_symbol
+  auto assign = [&](Object *value) {
+    if (global) global_binding_changed(var, value);
+    var = value;
+  };
+  auto body = list_members(expr);
+  for (size_t i = 0; i < count; ++i) {
+    assign(over_list ? list_index(range, i) : create_num_obj(i));
+    for (size_t j = 2; j < body.size(); ++j) eval_expr(body[j]);
+  }
+  if (saved_value != nullptr) {
+    assign(saved_value);
+  } else {
+    assign(nil_obj);
+    vars.erase(var_id);
+    if (!global) count_local_binding(var_id, -1);
+  }
+  return nil_obj;
+}
+
+// (defun (name args...) body...), binds the function to its name
+Object *eval_defun(Object *expr) {
+  auto l = list_members(expr);
+  auto *fundef_list = l[1];
+  // parse function definition list
+  if (obj_type(fundef_list) != ObjType::List) {
+    printf("Function definition list should be a list");
+    return nil_obj;
+  }
+  auto *funobj = new_object(ObjType::Function);
+  auto fundef_list_v = list_members(fundef_list);
+  auto funname = sym_id(fundef_list_v[0]);
+  gc_write_barrier(funobj, fundef_list);
+  gc_write_barrier(funobj, expr);
+  funobj->val.f_value.funargs = fundef_list;
+  funobj->val.f_value.funbody = expr;
+  set_symbol(funname, funobj);
+  return funobj;
+}
+
 void setup_builtins() {
-  set_symbol("nil", nil_obj);
-  set_symbol("true", true_obj);
-  set_symbol("false", false_obj);
-  set_symbol("else", else_obj);
-
-  BUILTIN_DEF("setq", EA::EQ, 2, ([](Object *expr) {
-                auto *l = expr->val.l_value;
-                Object *symname = l->at(1);
-                Object *symvalue = eval_expr(l->at(2));
-                set_symbol(*symname->val.s_value, symvalue);
-                return nil_obj;
-              }));
-
-  BUILTIN_DEF("to-string", EA::EQ, 1,
-              [](Object *expr) { return obj_to_string(list_index(expr, 1)); });
-
-  BUILTIN_DEF("print", EA::GEQ, 0, [](Object *expr) {
-    auto *l = expr->val.l_value;
-    int elems_len = l->size();
-    int arg_idx = 1;
-    while (arg_idx < elems_len) {
-      auto *arg = eval_expr(l->at(arg_idx));
-      auto *sobj = obj_to_string(arg);
+  set_symbol(intern("nil"), nil_obj);
+  set_symbol(intern("true"), true_obj);
+  set_symbol(intern("false"), false_obj);
+  set_symbol(intern("else"), else_obj);
+
+  SPECIAL_FORM_DEF("setq", EA::EQ, 2, ([](Object *expr) {
+                     auto l = list_members(expr);
+                     Object *symname = l[1];
+                     Object *symvalue = eval_expr(l[2]);
+                     set_symbol(sym_id(symname), symvalue);
+                     return nil_obj;
+                   }));
+
+  builtin_def<obj_to_string>("to-string");
+
+  BUILTIN_DEF("print", EA::GEQ, 0, [](Object **args, u32 nargs) {
+    for (u32 arg_idx = 0; arg_idx < nargs; ++arg_idx) {
+      auto *sobj = obj_to_string(args[arg_idx]);
       // TODO: Handle escape sequences
       printf("%s", sobj->val.s_value->data());
-      ++arg_idx;
     }
     printf("\n");
     return nil_obj;
   });
 
-  BUILTIN_DEF("begin", EA::GEQ, 1, [](Object *expr) {
-    auto *l = expr->val.l_value;
-    int elems_len = l->size();
+  SPECIAL_FORM_DEF("begin", EA::GEQ, 1, [](Object *expr) {
+    auto l = list_members(expr);
+    int elems_len = l.size();
     int arg_idx = 1;
     Object *last_evaluated = nil_obj;
     while (arg_idx < elems_len) {
-      auto *arg = eval_expr(l->at(arg_idx));
+      auto *arg = eval_expr(l[arg_idx]);
       last_evaluated = arg;
       ++arg_idx;
     }
     return last_evaluated;
   });
 
-  BUILTIN_DEF_FMT(
-      "defun", EA::GEQ, 2,
+  SPECIAL_FORM_DEF_FMT(
+      "defun", EA::GEQ, 2, eval_defun, [](auto name, EA mtype, u32 n, u32 k) {
+        return "Function should have an argument list and a body\n";
+      });
+
+  SPECIAL_FORM_DEF_FMT(
+      "defun-memo", EA::GEQ, 2,
       [](Object *expr) {
-        auto *l = expr->val.l_value;
-        auto *fundef_list = l->at(1);
-        // parse function definition list
-        if (fundef_list->type != ObjType::List) {
-          printf("Function definition list should be a list");
-          return nil_obj;
-        }
-        auto *funobj = new_object(ObjType::Function);
-        auto *fundef_list_v = fundef_list->val.l_value;
-        auto *funname = fundef_list_v->at(0)->val.s_value;
-        funobj->val.f_value.funargs = fundef_list;
-        funobj->val.f_value.funbody = expr;
-        set_symbol(*funname, funobj);
-        return funobj;
+        auto *funobj = eval_defun(expr);
+        if (funobj == nil_obj) return nil_obj;
+        auto *memo = create_memo_fobj(funobj, MEMO_DEFAULT_CAPACITY);
+        set_symbol(sym_id(list_index(list_index(expr, 1), 0)), memo);
+        return memo;
       },
       [](auto name, EA mtype, u32 n, u32 k) {
         return "Function should have an argument list and a body\n";
       });
 
-  BUILTIN_DEF_FMT(
+  // Records with fixed slots, see structs.hpp
+  SPECIAL_FORM_DEF("defstruct", EA::GEQ, 1, [](Object *expr) {
+    auto l = list_members(expr);
+    std::vector<std::string> fields;
+    for (auto *name : l.subspan(1)) {
+      if (obj_type(name) != ObjType::Symbol) {
+        auto *s = obj_to_string_bare(name);
+        error_msg(format("\"defstruct\" expects names, got \"{}\"", *s));
+        delete s;
+        return nil_obj;
+      }
+    }
+    for (auto *field : l.subspan(2)) fields.emplace_back(sym_name(field));
+    define_struct(std::string(sym_name(l[1])), fields);
+    return l[1];
+  });
+
+  SPECIAL_FORM_DEF_FMT(
       "lambda", EA::EQ, 2,
       [](Object *expr) {
-        auto *l = expr->val.l_value;
+        auto l = list_members(expr);
         // parse function definition list
-        auto *fundef_list = l->at(1);
-        if (fundef_list->type != ObjType::List) {
+        auto *fundef_list = l[1];
+        if (obj_type(fundef_list) != ObjType::List) {
           error_msg(
               format("First paremeter of lambda() should be a list, got \"{}\"",
-                     obj_type_to_str(fundef_list->type)));
+                     obj_type_to_str(obj_type(fundef_list))));
           return nil_obj;
         }
         auto *funobj = new_object(ObjType::Function);
         funobj->flags |= OF_LAMBDA;
+        gc_write_barrier(funobj, fundef_list);
+        gc_write_barrier(funobj, expr);
         funobj->val.f_value.funargs = fundef_list;
         funobj->val.f_value.funbody = expr;
         return funobj;
@@ -791,42 +1197,43 @@ void setup_builtins() {
         return "Lambdas should have an argument list and a body\n";
       });
 
-  BUILTIN_DEF("eval", EA::GEQ, 1, [](Object *expr) {
-    auto *l = expr->val.l_value;
-    u32 elems_len = l->size();
-    if (elems_len < 2) {
-      error_msg(
-          format("eval needs at least one expression to evaluate as an "
-                 "argument, got {}",
-                 elems_len));
-      return nil_obj;
-    }
+  BUILTIN_DEF("eval", EA::GEQ, 1, [](Object **args, u32 nargs) {
     Object *res = nil_obj;
-    auto saved_is = IS;
-    for (u32 i = 1; i < elems_len; ++i) {
-      auto *expr_obj = eval_expr(l->at(i));
-      if (expr_obj->type != ObjType::String) {
+    // errors are reported in the file eval is called from
+    ReaderContext reader{.file_name = IS.reader->file_name};
+    ReaderScope scope(reader);
+    for (u32 i = 0; i < nargs; ++i) {
+      auto *expr_obj = args[i];
+      if (obj_type(expr_obj) != ObjType::String) {
         error_msg(format("Eval can only evaluate strings, got \"{}\"",
-                         obj_type_to_str(expr_obj->type)));
+                         obj_type_to_str(obj_type(expr_obj))));
         res = nil_obj;
         break;
       }
-      IS.line = 1;
-      IS.col = 0;
-      IS.text = expr_obj->val.s_value->c_str();
-      IS.text_pos = 0;
-      Object *e = read_expr();
-      res = eval_expr(e);
-    }
-    IS = saved_is;
+      res = eval_string(*expr_obj->val.s_value);
+    }
     return res;
   });
 
-  BUILTIN_DEF("if", EA::EQ, 3, [](Object *expr) {
-    auto *l = expr->val.l_value;
-    auto *condition = l->at(1);
-    auto *then_expr = l->at(2);
-    auto *else_expr = l->at(3);
+  BUILTIN_DEF("eval-cache-stats", EA::EQ, 0, [](Object **args, u32 nargs) {
+    auto *res = create_hash_table_obj();
+    auto stat = [res](char const *name, u64 value) {
+      hash_table_set(res, create_str_obj(new std::string(name)),
+                     create_num_obj(value));
+    };
+    stat("hits", eval_cache.hits);
+    stat("misses", eval_cache.misses);
+    stat("evictions", eval_cache.evictions);
+    stat("size", eval_cache.entries.size());
+    stat("capacity", EVAL_CACHE_CAPACITY);
+    return res;
+  });
+
+  SPECIAL_FORM_DEF("if", EA::EQ, 3, [](Object *expr) {
+    auto l = list_members(expr);
+    auto *condition = l[1];
+    auto *then_expr = l[2];
+    auto *else_expr = l[3];
     if (is_truthy(eval_expr(condition))) {
       return eval_expr(then_expr);
     } else {
@@ -834,30 +1241,22 @@ void setup_builtins() {
     }
   });
 
-  BUILTIN_DEF_BINARY("=", objects_equal);
-  BUILTIN_DEF_BINARY("+", add_two_objects);
-  BUILTIN_DEF_BINARY("-", sub_two_objects);
-  BUILTIN_DEF_BINARY(">", objects_gt);
-  BUILTIN_DEF_BINARY("<", objects_lt);
-  BUILTIN_DEF_BINARY("/", objects_div);
-  BUILTIN_DEF_BINARY("remainder", objects_rem);
-  BUILTIN_DEF_BINARY("**", objects_pow);
-  BUILTIN_DEF_BINARY("*", objects_mul);
-
-  BUILTIN_DEF("not", EA::EQ, 1, [](Object *expr) {
-    auto *l = expr->val.l_value;
-    if (l->size() != 2) {
-      error_msg(
-          format("not takes exactly 1 argument, {} was given\n", l->size()));
-      return nil_obj;
-    }
-    auto *operand = eval_expr(l->at(1));
+  builtin_def<objects_equal>("=");
+  builtin_def<add_two_objects>("+");
+  builtin_def<sub_two_objects>("-");
+  builtin_def<objects_gt>(">");
+  builtin_def<objects_lt>("<");
+  builtin_def<objects_div>("/");
+  builtin_def<objects_rem>("remainder");
+  builtin_def<objects_pow>("**");
+  builtin_def<objects_mul>("*");
+
+  builtin_def<[](Object *operand) {
     if (is_truthy(operand)) return false_obj;
     return true_obj;
-  });
+  }>("not");
 
-  BUILTIN_DEF("car", EA::EQ, 1, [](Object *expr) {
-    auto *list_to_operate_on = eval_expr(list_index(expr, 1));
+  builtin_def<[](Object *list_to_operate_on) -> Object * {
     if (!is_list(list_to_operate_on)) {
       auto *s = obj_to_string_bare(list_to_operate_on);
       error_msg(format("car only operates on lists, got {}\n", s->data()));
@@ -866,10 +1265,9 @@ void setup_builtins() {
     }
     if (list_length(list_to_operate_on) < 1) return nil_obj;
     return list_index(list_to_operate_on, 0);
-  });
+  }>("car");
 
-  BUILTIN_DEF("cadr", EA::EQ, 1, [](Object *expr) {
-    auto *list_to_operate_on = eval_expr(list_index(expr, 1));
+  builtin_def<[](Object *list_to_operate_on) -> Object * {
     if (!is_list(list_to_operate_on)) {
       auto *s = obj_to_string_bare(list_to_operate_on);
       printf("cadr only operates on lists, got %s\n", s->data());
@@ -878,34 +1276,24 @@ void setup_builtins() {
     }
     if (list_length(list_to_operate_on) < 2) return nil_obj;
     return list_index(list_to_operate_on, 1);
-  });
+  }>("cadr");
 
-  BUILTIN_DEF("cdr", EA::EQ, 1, [](Object *expr) {
-    // currently creating a new list object for every cdr call. Maybe store
-    // as a linked list instead and return a pointer to the next of the head so
-    // that this call is only O(1)?
-    auto *new_list = create_list_obj();
-    auto *list_to_operate_on = eval_expr(list_index(expr, 1));
+  builtin_def<[](Object *list_to_operate_on) -> Object * {
     if (!is_list(list_to_operate_on)) {
       auto *s = obj_to_string_bare(list_to_operate_on);
       printf("cdr only operates on lists, got %s\n", s->data());
       delete s;
       return nil_obj;
     }
-    if (list_to_operate_on->type != ObjType::List) {
-      printf("cdr can only operate on lists\n");
-      return nil_obj;
-    }
     if (list_length(list_to_operate_on) < 1) return list_to_operate_on;
-    for (size_t i = 1; i < list_length(list_to_operate_on); ++i) {
-      auto *evaluated_item = list_index(list_to_operate_on, i);
-      list_append_inplace(new_list, evaluated_item);
-    }
-    new_list->flags |= OF_EVALUATED;
-    return new_list;
-  });
-
-  BUILTIN_DEF("cond", EA::GEQ, 1, [](Object *expr) {
+    // shares the members with the list instead of copying them
+    auto *rest = list_slice(list_to_operate_on, 1,
+                            list_length(list_to_operate_on));
+    rest->flags |= OF_EVALUATED;
+    return rest;
+  }>("cdr");
+
+  SPECIAL_FORM_DEF("cond", EA::GEQ, 1, [](Object *expr) {
     // sequentually check every provided condition
     // and if one of them is true, return the provided value
     if (list_length(expr) < 2) {
@@ -930,24 +1318,24 @@ void setup_builtins() {
     return nil_obj;
   });
 
-  BUILTIN_DEF("let", EA::EQ, 2, [](Object *expr) {
+  SPECIAL_FORM_DEF("let", EA::EQ, 2, [](Object *expr) {
     enter_scope();
     auto *bindings = list_index(expr, 1);
     for (size_t idx = 0; idx < list_length(bindings); ++idx) {
       auto *let_pair = list_index(bindings, idx);
-      if (let_pair->type != ObjType::List) {
+      if (obj_type(let_pair) != ObjType::List) {
         error_msg(format("let binding list should consist of lists, got \"{}\"",
-                         obj_type_to_str(let_pair->type)));
+                         obj_type_to_str(obj_type(let_pair))));
         break;
       }
       auto *let_name = list_index(let_pair, 0);
       auto *let_value = eval_expr(list_index(let_pair, 1));
-      if (let_name->type != ObjType::Symbol) {
+      if (obj_type(let_name) != ObjType::Symbol) {
         error_msg(format("let binding name must be a symbol, got \"{}\"",
-                         obj_type_to_str(let_name->type)));
+                         obj_type_to_str(obj_type(let_name))));
         break;
       }
-      set_symbol(*let_name->val.s_value, let_value);
+      set_symbol(sym_id(let_name), let_value);
     }
     auto *let_body = list_index(expr, 2);
     auto *res = eval_expr(let_body);
@@ -955,23 +1343,72 @@ void setup_builtins() {
     return res;
   });
 
-  BUILTIN_DEF("cons", EA::GEQ, 2, [](Object *expr) {
+  SPECIAL_FORM_DEF("while", EA::GEQ, 1, [](Object *expr) {
+    auto body = list_members(expr);
+    while (is_truthy(eval_expr(body[1]))) {
+      for (size_t i = 2; i < body.size(); ++i) eval_expr(body[i]);
+    }
+    return nil_obj;
+  });
+
+  SPECIAL_FORM_DEF("dotimes", EA::GEQ, 1, [](Object *expr) {
+    return eval_for_loop(expr, false);
+  });
+
+  SPECIAL_FORM_DEF("dolist", EA::GEQ, 1, [](Object *expr) {
+    return eval_for_loop(expr, true);
+  });
+
+  BUILTIN_DEF("cons", EA::GEQ, 2, [](Object **args, u32 nargs) {
     auto *res = create_data_list_obj();
-    for (size_t idx = 1; idx < list_length(expr); ++idx) {
-      auto *lexpr = list_index(expr, idx);
-      auto *l = eval_expr(lexpr);
-      list_append_list_inplace(res, l);
+    for (u32 idx = 0; idx < nargs; ++idx) {
+      list_append_list_inplace(res, args[idx]);
     }
     return res;
   });
 
-  BUILTIN_DEF("memtotal", EA::EQ, 0, [](Object *expr) {
+  BUILTIN_DEF("memtotal", EA::EQ, 0, [](Object **args, u32 nargs) {
     size_t memtotal = get_total_memory_usage();
-    return create_num_obj(memtotal);
+    return create_int_obj(memtotal);
+  });
+
+  BUILTIN_DEF("objects-allocated", EA::EQ, 0, [](Object **args, u32 nargs) {
+    return create_num_obj(HEAP.stats.objects_allocated);
+  });
+
+  BUILTIN_DEF("heap-stats", EA::EQ, 0, [](Object **args, u32 nargs) {
+    auto *res = create_hash_table_obj();
+    auto stat = [res](char const *name, u64 value) {
+      hash_table_set(res, create_str_obj(new std::string(name)),
+                     create_num_obj(value));
+    };
+    stat("bytes-allocated", HEAP.stats.bytes_allocated);
+    stat("bytes-in-use", heap_bytes_in_use());
+    stat("external-bytes", heap_external_bytes());
+    stat("pages", HEAP.stats.pages);
+    stat("fragmentation", heap_fragmentation());
+    return res;
+  });
+
+  // pause times are in microseconds
+  BUILTIN_DEF("gc-stats", EA::EQ, 0, [](Object **args, u32 nargs) {
+    auto *res = create_hash_table_obj();
+    auto stat = [res](char const *name, u64 value) {
+      hash_table_set(res, create_str_obj(new std::string(name)),
+                     create_num_obj(value));
+    };
+    stat("cycles", GC.stats.pauses_ms.size());
+    stat("minor-cycles", GC.stats.minor_cycles);
+    stat("major-cycles", GC.stats.major_cycles);
+    stat("objects-freed", GC.stats.objects_freed);
+    stat("p99-pause", gc_pause_percentile(0.99) * 1000);
+    stat("max-pause", GC.stats.max_pause_ms * 1000);
+    stat("total-pause", GC.stats.total_pause_ms * 1000);
+    return res;
   });
 
   using TimeItTime = duration<double, std::milli>;
-  BUILTIN_DEF("timeit", EA::EQ, 0, [](Object *expr) {
+  SPECIAL_FORM_DEF("timeit", EA::EQ, 1, [](Object *expr) {
     auto *expr_to_time = list_index(expr, 1);
     auto start_time = high_resolution_clock::now();
     // discard the result
@@ -983,19 +1420,19 @@ void setup_builtins() {
     return create_str_obj(rtime_s);
   });
 
-  BUILTIN_DEF("sleep", EA::EQ, 0, [](Object *expr) {
-    auto *ms_num_obj = list_index(expr, 1);
-    auto ms = ms_num_obj->val.i_value;
+  BUILTIN_DEF("sleep", EA::EQ, 1, [](Object **args, u32 nargs) {
+    if (!expect_arg_type(args, "sleep", 0, ObjType::Number)) return nil_obj;
+    auto ms = num_value(args[0]);
     // sleep the execution thread
     std::this_thread::sleep_for(std::chrono::milliseconds(ms));
     return nil_obj;
   });
 
-  BUILTIN_DEF("input", EA::GEQ, 0, [](Object *expr) {
-    bool has_prompt = list_length(expr) == 2;
+  BUILTIN_DEF("input", EA::LEQ, 1, [](Object **args, u32 nargs) {
+    bool has_prompt = nargs == 1;
     if (has_prompt) {
-      if (!expect_arg_type(expr, "input", 1, ObjType::String)) return nil_obj;
-      Object *prompt = list_index(expr, 1);
+      if (!expect_arg_type(args, "input", 0, ObjType::String)) return nil_obj;
+      Object *prompt = args[0];
       auto *prompt_s = prompt->val.s_value;
       std::cout << *prompt_s;
     }
@@ -1006,37 +1443,411 @@ void setup_builtins() {
     return res;
   });
 
-  BUILTIN_DEF("make-hash-table", EA::EQ, 0, [](Object *expr) {
+  BUILTIN_DEF("make-hash-table", EA::EQ, 0, [](Object **args, u32 nargs) {
     // TODO: Process arguments
     return create_hash_table_obj();
   });
 
-  BUILTIN_DEF("get-hash", EA::EQ, 2, [](Object *expr) {
-    if (!check_builtin_n_params("get-hash", expr, 2)) return nil_obj;
-    auto *ht = eval_expr(list_index(expr, 1));
-    auto *key = eval_expr(list_index(expr, 2));
-    auto *val = hash_table_get(ht, key);
-    return val;
+  BUILTIN_DEF("get-hash", EA::EQ, 2, [](Object **args, u32 nargs) {
+    if (!expect_arg_type(args, "get-hash", 0, ObjType::HashTable)) {
+      return nil_obj;
+    }
+    return hash_table_get(args[0], args[1]);
+  });
+
+  BUILTIN_DEF("set-hash", EA::EQ, 3, [](Object **args, u32 nargs) {
+    if (!expect_arg_type(args, "set-hash", 0, ObjType::HashTable)) {
+      return nil_obj;
+    }
+    hash_table_set(args[0], args[1], args[2]);
+    return nil_obj;
+  });
+
+  BUILTIN_DEF("remove-hash", EA::EQ, 2, [](Object **args, u32 nargs) {
+    if (!expect_arg_type(args, "remove-hash", 0, ObjType::HashTable)) {
+      return nil_obj;
+    }
+    return bool_obj_from(hash_table_remove(args[0], args[1]));
+  });
+
+  BUILTIN_DEF("hash-count", EA::EQ, 1, [](Object **args, u32 nargs) {
+    if (!expect_arg_type(args, "hash-count", 0, ObjType::HashTable)) {
+      return nil_obj;
+    }
+    return create_num_obj(hash_table_count(args[0]));
+  });
+
+  BUILTIN_DEF("make-persistent-map", EA::EQ, 0, [](Object **args, u32 nargs) {
+    return create_pmap_obj(nullptr, 0);
+  });
+
+  BUILTIN_DEF("lookup", EA::EQ, 2, [](Object **args, u32 nargs) {
+    if (!expect_arg_type(args, "lookup", 0, ObjType::PersistentMap)) {
+      return nil_obj;
+    }
+    auto hash = obj_hash(args[1]);
+    if (!hash) return nil_obj;
+    auto *res = pmap_lookup(args[0], *hash, args[1]);
+    return res != nullptr ? res : nil_obj;
+  });
+
+  BUILTIN_DEF("assoc", EA::EQ, 3, [](Object **args, u32 nargs) {
+    if (!expect_arg_type(args, "assoc", 0, ObjType::PersistentMap)) {
+      return nil_obj;
+    }
+    auto hash = obj_hash(args[1]);
+    if (!hash) return nil_obj;
+    return pmap_assoc(args[0], *hash, args[1], args[2]);
+  });
+
+  BUILTIN_DEF("dissoc", EA::EQ, 2, [](Object **args, u32 nargs) {
+    if (!expect_arg_type(args, "dissoc", 0, ObjType::PersistentMap)) {
+      return nil_obj;
+    }
+    auto hash = obj_hash(args[1]);
+    if (!hash) return nil_obj;
+    return pmap_dissoc(args[0], *hash, args[1]);
+  });
+
+  BUILTIN_DEF("map-count", EA::EQ, 1, [](Object **args, u32 nargs) {
+    if (!expect_arg_type(args, "map-count", 0, ObjType::PersistentMap)) {
+      return nil_obj;
+    }
+    return create_num_obj(args[0]->val.pmap_value.count);
+  });
+
+  BUILTIN_DEF("hash-table->map", EA::EQ, 1, [](Object **args, u32 nargs) {
+    if (!expect_arg_type(args, "hash-table->map", 0, ObjType::HashTable)) {
+      return nil_obj;
+    }
+    return hash_table_to_pmap(args[0]);
+  });
+
+  BUILTIN_DEF("map->hash-table", EA::EQ, 1, [](Object **args, u32 nargs) {
+    if (!expect_arg_type(args, "map->hash-table", 0, ObjType::PersistentMap)) {
+      return nil_obj;
+    }
+    return pmap_to_hash_table(args[0]);
+  });
+
+  // Numeric vectors, see num_vector.hpp
+  BUILTIN_DEF("make-i64vector", EA::GEQ, 1, [](Object **args, u32 nargs) {
+    return make_num_vector(args, nargs, "make-i64vector", VecKind::I64);
+  });
+
+  BUILTIN_DEF("make-f64vector", EA::GEQ, 1, [](Object **args, u32 nargs) {
+    return make_num_vector(args, nargs, "make-f64vector", VecKind::F64);
+  });
+
+  BUILTIN_DEF("list->i64vector", EA::EQ, 1, [](Object **args, u32 nargs) {
+    return list_to_num_vector(args, "list->i64vector", VecKind::I64);
+  });
+
+  BUILTIN_DEF("list->f64vector", EA::EQ, 1, [](Object **args, u32 nargs) {
+    return list_to_num_vector(args, "list->f64vector", VecKind::F64);
+  });
+
+  BUILTIN_DEF("vec->list", EA::EQ, 1, [](Object **args, u32 nargs) {
+    if (!expect_arg_type(args, "vec->list", 0, ObjType::NumVector)) {
+      return nil_obj;
+    }
+    auto *res = create_data_list_obj();
+    list_reserve(res, vec_length(args[0]));
+    for (size_t i = 0; i < vec_length(args[0]); ++i) {
+      list_append_inplace(res, vec_ref(args[0], i));
+    }
+    return res;
+  });
+
+  BUILTIN_DEF("vec-length", EA::EQ, 1, [](Object **args, u32 nargs) {
+    if (!expect_arg_type(args, "vec-length", 0, ObjType::NumVector)) {
+      return nil_obj;
+    }
+    return create_num_obj(vec_length(args[0]));
+  });
+
+  BUILTIN_DEF("vec-ref", EA::EQ, 2, [](Object **args, u32 nargs) {
+    auto i = vec_index_arg(args, "vec-ref");
+    if (i < 0) return nil_obj;
+    return vec_ref(args[0], i);
+  });
+
+  BUILTIN_DEF("vec-set", EA::EQ, 3, [](Object **args, u32 nargs) {
+    auto i = vec_index_arg(args, "vec-set");
+    if (i < 0 ||
+        !expect_vec_element_arg(args, "vec-set", 2, vec_kind(args[0]))) {
+      return nil_obj;
+    }
+    vec_set(args[0], i, args[2]);
+    return args[2];
+  });
+
+  BUILTIN_DEF("vec-add", EA::EQ, 2, [](Object **args, u32 nargs) {
+    if (!expect_vec_pair(args, "vec-add")) return nil_obj;
+    auto &a = args[0]->val.vec_value;
+    auto &b = args[1]->val.vec_value;
+    auto *res = create_num_vector_obj(a.kind, a.size);
+    auto &out = res->val.vec_value;
+    if (a.kind == VecKind::I64) {
+      if (!vec_add(a.i64s, b.i64s, out.i64s, a.size)) {
+        return error_vec_overflow("vec-add");
+      }
+    } else {
+      vec_add(a.f64s, b.f64s, out.f64s, a.size);
+    }
+    return res;
+  });
+
+  BUILTIN_DEF("vec-mul", EA::EQ, 2, [](Object **args, u32 nargs) {
+    if (!expect_vec_pair(args, "vec-mul")) return nil_obj;
+    auto &a = args[0]->val.vec_value;
+    auto &b = args[1]->val.vec_value;
+    auto *res = create_num_vector_obj(a.kind, a.size);
+    auto &out = res->val.vec_value;
+    if (a.kind == VecKind::I64) {
+      if (!vec_mul(a.i64s, b.i64s, out.i64s, a.size)) {
+        return error_vec_overflow("vec-mul");
+      }
+    } else {
+      vec_mul(a.f64s, b.f64s, out.f64s, a.size);
+    }
+    return res;
+  });
+
+  BUILTIN_DEF("vec-scale", EA::EQ, 2, [](Object **args, u32 nargs) {
+    if (!expect_arg_type(args, "vec-scale", 0, ObjType::NumVector) ||
+        !expect_vec_element_arg(args, "vec-scale", 1, vec_kind(args[0]))) {
+      return nil_obj;
+    }
+    auto &a = args[0]->val.vec_value;
+    auto *res = create_num_vector_obj(a.kind, a.size);
+    auto &out = res->val.vec_value;
+    if (a.kind == VecKind::I64) {
+      if (!vec_scale(a.i64s, num_value(args[1]), out.i64s, a.size)) {
+        return error_vec_overflow("vec-scale");
+      }
+    } else {
+      vec_scale(a.f64s, num_to_double(args[1]), out.f64s, a.size);
+    }
+    return res;
+  });
+
+  BUILTIN_DEF("vec-prefix-sum", EA::EQ, 1, [](Object **args, u32 nargs) {
+    if (!expect_arg_type(args, "vec-prefix-sum", 0, ObjType::NumVector)) {
+      return nil_obj;
+    }
+    auto &a = args[0]->val.vec_value;
+    auto *res = create_num_vector_obj(a.kind, a.size);
+    auto &out = res->val.vec_value;
+    if (a.kind == VecKind::I64) {
+      if (!vec_prefix_sum(a.i64s, out.i64s, a.size)) {
+        return error_vec_overflow("vec-prefix-sum");
+      }
+    } else {
+      vec_prefix_sum(a.f64s, out.f64s, a.size);
+    }
+    return res;
+  });
+
+  BUILTIN_DEF("vec-dot", EA::EQ, 2, [](Object **args, u32 nargs) {
+    if (!expect_vec_pair(args, "vec-dot")) return nil_obj;
+    auto &a = args[0]->val.vec_value;
+    auto &b = args[1]->val.vec_value;
+    if (a.kind == VecKind::I64) return vec_dot_obj(args[0], args[1]);
+    return create_float_obj(vec_dot(a.f64s, b.f64s, a.size));
+  });
+
+  BUILTIN_DEF("vec-sum", EA::EQ, 1, [](Object **args, u32 nargs) {
+    if (!expect_arg_type(args, "vec-sum", 0, ObjType::NumVector)) {
+      return nil_obj;
+    }
+    auto &a = args[0]->val.vec_value;
+    if (a.kind == VecKind::I64) return vec_sum_obj(args[0]);
+    return create_float_obj(vec_sum(a.f64s, a.size));
+  });
+
+  // nil for empty vectors
+  BUILTIN_DEF("vec-min", EA::EQ, 1, [](Object **args, u32 nargs) {
+    if (!expect_arg_type(args, "vec-min", 0, ObjType::NumVector)) {
+      return nil_obj;
+    }
+    auto &a = args[0]->val.vec_value;
+    if (a.size == 0) return nil_obj;
+    if (a.kind == VecKind::I64) return create_int_obj(vec_min(a.i64s, a.size));
+    return create_float_obj(vec_min(a.f64s, a.size));
+  });
+
+  BUILTIN_DEF("vec-max", EA::EQ, 1, [](Object **args, u32 nargs) {
+    if (!expect_arg_type(args, "vec-max", 0, ObjType::NumVector)) {
+      return nil_obj;
+    }
+    auto &a = args[0]->val.vec_value;
+    if (a.size == 0) return nil_obj;
+    if (a.kind == VecKind::I64) return create_int_obj(vec_max(a.i64s, a.size));
+    return create_float_obj(vec_max(a.f64s, a.size));
   });
 
-  BUILTIN_DEF("set-hash", EA::EQ, 3, [](Object *expr) {
-    auto *ht = eval_expr(list_index(expr, 1));
-    auto *key = eval_expr(list_index(expr, 2));
-    auto *val = eval_expr(list_index(expr, 3));
-    hash_table_set(ht, key, val);
+  builtin_def<[](Object *obj) {
+    return is_truthy(obj) ? false_obj : true_obj;
+  }>("null?");
+
+  // The list library. Like the cons-based versions in stdlib/basic.lisp
+  // (still there as lisp-length, lisp-map...), the members that are lists
+  // are spliced into the lists built.
+  BUILTIN_DEF("length", EA::EQ, 1, [](Object **args, u32 nargs) {
+    std::span<Object *> items;
+    if (!expect_list_arg(args, "length", 0, items)) return nil_obj;
+    return create_num_obj(items.size());
+  });
+
+  BUILTIN_DEF("append", EA::EQ, 2, [](Object **args, u32 nargs) {
+    std::span<Object *> items;
+    if (!expect_list_arg(args, "append", 0, items)) return nil_obj;
+    if (items.empty()) return args[1];
+    auto *res = create_data_list_obj();
+    list_reserve(res, items.size() + 1);
+    for (auto *item : items) list_append_list_inplace(res, item);
+    list_append_list_inplace(res, args[1]);
+    return res;
+  });
+
+  BUILTIN_DEF("reverse", EA::EQ, 1, [](Object **args, u32 nargs) {
+    std::span<Object *> items;
+    if (!expect_list_arg(args, "reverse", 0, items)) return nil_obj;
+    auto *res = create_data_list_obj();
+    list_reserve(res, items.size());
+    for (size_t i = items.size(); i > 0; --i) {
+      list_append_list_inplace(res, items[i - 1]);
+    }
+    return res;
+  });
+
+  BUILTIN_DEF("nth", EA::EQ, 2, [](Object **args, u32 nargs) {
+    std::span<Object *> items;
+    if (!expect_list_arg(args, "nth", 0, items) ||
+        !expect_arg_type(args, "nth", 1, ObjType::Number)) {
+      return nil_obj;
+    }
+    auto i = num_value(args[1]);
+    if (i < 0 || (size_t)i >= items.size()) return nil_obj;
+    return items[i];
+  });
+
+  BUILTIN_DEF("last", EA::EQ, 1, [](Object **args, u32 nargs) {
+    std::span<Object *> items;
+    if (!expect_list_arg(args, "last", 0, items)) return nil_obj;
+    return items.empty() ? nil_obj : items.back();
+  });
+
+  // (sublist list from [to]), shares the members with the list
+  BUILTIN_DEF("sublist", EA::GEQ, 2, [](Object **args, u32 nargs) {
+    std::span<Object *> items;
+    if (!expect_list_arg(args, "sublist", 0, items) ||
+        !expect_arg_type(args, "sublist", 1, ObjType::Number) ||
+        (nargs > 2 && !expect_arg_type(args, "sublist", 2, ObjType::Number))) {
+      return nil_obj;
+    }
+    if (args[0] == nil_obj) return create_data_list_obj();
+    size_t from = std::max<i64>(0, num_value(args[1]));
+    size_t to = nargs > 2 ? std::max<i64>(0, num_value(args[2])) : items.size();
+    return list_slice(args[0], from, to);
+  });
+
+  // The callbacks may collect garbage, the lists being built are kept on the
+  // VM stack meanwhile
+  BUILTIN_DEF("map", EA::EQ, 2, [](Object **args, u32 nargs) {
+    std::span<Object *> items;
+    if (!expect_list_arg(args, "map", 1, items)) return nil_obj;
+    auto *fn = args[0];
+    auto *list = args[1];
+    auto *res = create_data_list_obj();
+    if (!vm_push_root(res)) return nil_obj;
+    list_reserve(res, items.size());
+    for (size_t i = 0; i < items.size(); ++i) {
+      auto *item = list_index(list, i);
+      list_append_list_inplace(res, apply_callable(fn, &item, 1));
+    }
+    vm_pop_root();
+    return res;
+  });
+
+  BUILTIN_DEF("for-each", EA::EQ, 2, [](Object **args, u32 nargs) {
+    std::span<Object *> items;
+    if (!expect_list_arg(args, "for-each", 1, items)) return nil_obj;
+    for (size_t i = 0; i < items.size(); ++i) {
+      auto *item = list_index(args[1], i);
+      apply_callable(args[0], &item, 1);
+    }
     return nil_obj;
   });
 
-  BUILTIN_DEF("null?", EA::EQ, 1, [](Object *expr) {
-    auto *e = list_index(expr, 1);
-    auto *ee = eval_expr(e);
-    return is_truthy(ee) ? false_obj : true_obj;
+  // (accumulate p list initial) folds from the end: (p (p initial last) ...)
+  BUILTIN_DEF("accumulate", EA::EQ, 3, [](Object **args, u32 nargs) {
+    std::span<Object *> items;
+    if (!expect_list_arg(args, "accumulate", 1, items)) return nil_obj;
+    // the accumulated value and the member
+    Object *p_args[2];
+    p_args[0] = args[2];
+    for (size_t i = items.size(); i > 0; --i) {
+      p_args[1] = list_index(args[1], i - 1);
+      p_args[0] = apply_callable(args[0], p_args, 2);
+    }
+    return p_args[0];
   });
 
-  BUILTIN_DEF("import", EA::EQ, 1, [](Object *expr) {
-    auto *e = list_index(expr, 1);
-    auto *ee = eval_expr(e);
-    import_module(ee->val.s_value);
+  // Memoized functions, see memo.hpp
+  BUILTIN_DEF("memoize", EA::GEQ, 1, [](Object **args, u32 nargs) {
+    if (nargs > 2) {
+      error_msg(format("\"memoize\" expects at most 2 arguments, {} was given",
+                       nargs));
+      return nil_obj;
+    }
+    if (!expect_arg_type(args, "memoize", 0, ObjType::Function)) {
+      return nil_obj;
+    }
+    if (obj_flags(args[0]) & OF_SPECIAL) {
+      error_msg(format("Special form \"{}\" can't be memoized",
+                       fun_name(args[0])));
+      return nil_obj;
+    }
+    size_t capacity = MEMO_DEFAULT_CAPACITY;
+    if (nargs == 2) {
+      if (!expect_arg_type(args, "memoize", 1, ObjType::Number)) {
+        return nil_obj;
+      }
+      capacity = std::max<i64>(0, num_value(args[1]));
+    }
+    return create_memo_fobj(args[0], capacity);
+  });
+  memoize_builtin = get_global(intern("memoize"));
+
+  BUILTIN_DEF("memo-stats", EA::EQ, 1, [](Object **args, u32 nargs) {
+    if (!expect_memo_arg(args, "memo-stats", 0)) return nil_obj;
+    auto &cache = *args[0]->val.memo_value.cache;
+    auto *res = create_hash_table_obj();
+    auto stat = [res](char const *name, u64 value) {
+      hash_table_set(res, create_str_obj(new std::string(name)),
+                     create_num_obj(value));
+    };
+    stat("hits", cache.hits);
+    stat("misses", cache.misses);
+    stat("evictions", cache.evictions);
+    stat("size", cache.entries.size());
+    stat("capacity", cache.capacity);
+    return res;
+  });
+  BUILTIN_DEF("set-memo-capacity", EA::EQ, 2, [](Object **args, u32 nargs) {
+    if (!expect_memo_arg(args, "set-memo-capacity", 0) ||
+        !expect_arg_type(args, "set-memo-capacity", 1, ObjType::Number)) {
+      return nil_obj;
+    }
+    memo_set_capacity(args[0], std::max<i64>(0, num_value(args[1])));
+    return nil_obj;
+  });
+
+  BUILTIN_DEF("import", EA::EQ, 1, [](Object **args, u32 nargs) {
+    if (!expect_arg_type(args, "import", 0, ObjType::String)) return nil_obj;
+    import_module(args[0]->val.s_value);
     return nil_obj;
   });
 }
@@ -1045,15 +1856,14 @@ void init_interp() {
   // Initialize global symbol table
   IS.symtable = new SymTable();
   IS.symtable->prev = nullptr;
-  nil_obj = create_nil_obj();
-  true_obj = create_bool_obj(true);
-  false_obj = create_bool_obj(false);
+  IS.globals = IS.symtable;
+  init_vm();
+  init_gc();
   dot_obj = create_final_sym_obj(".");
   else_obj = create_final_sym_obj("else");
   setup_builtins();
-  // setup gc
+  init_optimizer();
   IS.running = true;
-  init_gc();
   // Load the standard library
   load_file(STDLIB_PATH / path("basic.lisp"));
 }
@@ -1062,9 +1872,8 @@ void run_interp() {
   assert_stmt(IS.running, "");
   std::string input;
   static std::string prompt = ">> ";
-  IS.file_name = "interp";
-  IS.line = 1;
-  IS.col = 0;
+  ReaderContext reader{.file_name = "interp"};
+  ReaderScope scope(reader);
 
   char c;
   while (IS.running) {
@@ -1080,15 +1889,16 @@ void run_interp() {
       IS.running = false;
       continue;
     }
-    IS.text = input.data();
-    IS.text_pos = 0;
-    IS.text_len = input.size();
+    reader.text = input.data();
+    reader.text_pos = 0;
+    reader.text_len = input.size();
     auto *e = read_expr();
     if (e != nullptr) {
-      auto *res = eval_expr(e);
+      auto *res = eval_toplevel(e);
       auto *str_repr = obj_to_string_bare(res);
       std::cout << str_repr->data() << '\n';
       delete str_repr;
+      if (gc_wanted()) gc_step();
     }
     input = "";
   }
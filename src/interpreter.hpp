@@ -4,48 +4,90 @@
 #include <unordered_map>
 #include <filesystem>
 #include <string>
-#include <thread>
 #include <vector>
-#include <fstream>
-#include <list>
 
 #include "types.hpp"
 
-const auto GC_INTERVAL = std::chrono::milliseconds(5000);
-const auto GC_LOG_FILE = "lisp-gc.log";
-
 using std::filesystem::path;
 
 struct Object;
+struct BuiltinSpec;
 
-using SymVars = std::unordered_map<std::string, Object *>;
+using SymVars = std::unordered_map<SymbolId, Object *>;
 struct SymTable {
   SymVars map;
   SymTable *prev;
 };
 
-struct InterpreterState {
-  const char *text;
+// Where the reader is in the text it reads, and the name of the file
+// reported in the error messages. Every load of a file, eval and REPL
+// line reads with a context of its own, see ReaderScope.
+struct ReaderContext {
+  const char *text = "";
   int text_pos = 0;
-  int text_len;
-  SymTable *symtable;
-  // current module info
-  const char* file_name = nullptr;
+  int text_len = 0;
+  const char *file_name = nullptr;
   u32 line = 1;
   u32 col = 0;
-  bool running = false;
-  // Pool of all objects allocated. Needed for GC
-  // @PERFORMANCE: Custom allocator?
-  std::list<Object*> objects_pool;
 };
 
-struct GarbageCollector {
-  std::thread* thread = nullptr;
-  std::ofstream* log_file = nullptr;
+struct InterpreterState {
+  // the context read from, never null
+  ReaderContext *reader;
+  SymTable *symtable;
+  // bottom of the symtable chain, the compiled code only looks up
+  // globals by name
+  SymTable *globals;
+  bool running = false;
+  // evaluate with the tree-walking eval_expr instead of the bytecode VM
+  bool tree_walk = false;
+  // fold the constants of the forms before evaluating them, see
+  // optimizer.hpp
+  bool fold_constants = true;
 };
 
 extern InterpreterState IS;
 
+// Reads from the context until the end of the scope, then goes back to the
+// one read from before. Nested loads (import inside a file, eval) only
+// save a pointer.
+struct ReaderScope {
+  ReaderContext *saved;
+  explicit ReaderScope(ReaderContext &ctx) : saved(IS.reader) {
+    IS.reader = &ctx;
+  }
+  ~ReaderScope() { IS.reader = saved; }
+  ReaderScope(ReaderScope const &) = delete;
+  ReaderScope &operator=(ReaderScope const &) = delete;
+};
+
+extern size_t call_stack_size;
+const size_t MAX_STACK_SIZE = 256;
+
+void set_symbol(SymbolId key, Object *value);
+Object *get_symbol(SymbolId key);
+void set_global(SymbolId key, Object *value);
+Object *get_global(SymbolId key);
+void enter_scope();
+void enter_scope_with(SymVars vars);
+void exit_scope();
+
+Object *read_expr();
+// Tree-walking evaluator
+Object *eval_expr(Object *expr);
+// Evaluates a top-level form with the selected evaluator
+Object *eval_toplevel(Object *expr);
+// Calls a tree-walker function with already evaluated arguments
+Object *apply_function(Object *fobj, Object **args, u32 nargs);
+// Calls any function object with already evaluated arguments, with the
+// evaluator it was made for
+Object *apply_callable(Object *fobj, Object **args, u32 nargs);
+
+// Reports a call to a built-in with a number of arguments it doesn't take
+bool check_builtin_arity(Object *fobj, u64 nargs);
+// Same for anything else with a spec, like the functions of structs
+bool check_arity(BuiltinSpec const *spec, u64 nargs);
+
 bool load_file(path file_to_read);
 void init_interp();
 void run_interp();
@@ -13,14 +13,25 @@
 #include <utility>
 #include <vector>
 
+#include "gc.hpp"
 #include "interpreter.hpp"
+#include "num_vector.hpp"
 #include "objects.hpp"
 #include "platform/platform.hpp"
 #include "util.hpp"
+#include "vm.hpp"
 
 struct Arguments {
   std::vector<char *> ordered_args;
   bool run_interp = false;
+  bool tree_walk = false;
+  bool fold_constants = true;
+  // run the numeric vector operations with plain loops
+  bool no_simd = false;
+  // collect the whole heap every time instead of the young generation
+  bool gc_full = false;
+  double gc_pause_ms = GC_DEFAULT_PAUSE_MS;
+  size_t stack_mb = DEFAULT_STACK_BUDGET_MB;
 };
 
 Arguments *parse_args(int argc, char **argv) {
@@ -41,6 +52,35 @@ Arguments *parse_args(int argc, char **argv) {
         char *arg_payload = arg + 2;
         if (!strcmp(arg_payload, "interpreter")) {
           res->run_interp = true;
+        } else if (!strcmp(arg_payload, "tree-walk")) {
+          res->tree_walk = true;
+        } else if (!strcmp(arg_payload, "no-fold")) {
+          res->fold_constants = false;
+        } else if (!strcmp(arg_payload, "no-simd")) {
+          res->no_simd = true;
+        } else if (!strcmp(arg_payload, "gc-full")) {
+          res->gc_full = true;
+        } else if (!strcmp(arg_payload, "gc-pause-ms")) {
+          char *end = nullptr;
+          if (argidx + 1 < argc) {
+            res->gc_pause_ms = strtod(argv[argidx + 1], &end);
+          }
+          if (end == nullptr || *end != '\0' || res->gc_pause_ms <= 0) {
+            printf("Error: %s expects a positive number of milliseconds\n",
+                   arg);
+            return nullptr;
+          }
+          ++argidx;
+        } else if (!strcmp(arg_payload, "stack-mb")) {
+          char *end = nullptr;
+          if (argidx + 1 < argc) {
+            res->stack_mb = strtoull(argv[argidx + 1], &end, 10);
+          }
+          if (end == nullptr || *end != '\0' || res->stack_mb == 0) {
+            printf("Error: %s expects a positive number of megabytes\n", arg);
+            return nullptr;
+          }
+          ++argidx;
         } else {
           printf("Error: Unknown argument %s\n", arg);
           return nullptr;
@@ -59,6 +99,9 @@ Arguments *parse_args(int argc, char **argv) {
           case 'i': {
             res->run_interp = true;
           } break;
+          case 't': {
+            res->tree_walk = true;
+          } break;
           default: {
             printf("Error: Unknown argument: %s\n", arg);
             return nullptr;
@@ -79,6 +122,12 @@ int main(int argc, char **argv) {
   if (args == nullptr) {
     return -1;
   }
+  IS.tree_walk = args->tree_walk;
+  IS.fold_constants = args->fold_constants;
+  vec_simd = !args->no_simd;
+  VM.budget = args->stack_mb << 20;
+  GC.generational = !args->gc_full;
+  GC.pause_budget_ms = args->gc_pause_ms;
   init_interp();
   if (args->run_interp) {
     printf("Running interpreter\n");
@@ -0,0 +1,69 @@
+#include "memo.hpp"
+
+#include "interpreter.hpp"
+
+Object *memoize_builtin = nullptr;
+
+Object *create_memo_fobj(Object *fun, size_t capacity) {
+  auto *res = new_object(ObjType::Function, OF_MEMOIZED | OF_EVALUATED);
+  gc_write_barrier(res, fun);
+  res->val.memo_value.fun = fun;
+  res->val.memo_value.cache = new MemoCache{capacity};
+  return res;
+}
+
+void delete_memo_cache(MemoCache *cache) { delete cache; }
+
+void evict_entries(MemoCache &cache, size_t capacity) {
+  while (cache.entries.size() > capacity) {
+    auto last = std::prev(cache.entries.end());
+    auto [it, end] = cache.index.equal_range(last->hash);
+    while (it->second != last) ++it;
+    cache.index.erase(it);
+    cache.entries.pop_back();
+    ++cache.evictions;
+  }
+}
+
+Object *memo_call(Object *memo, Object **args, u32 nargs) {
+  auto *fun = memo->val.memo_value.fun;
+  auto &cache = *memo->val.memo_value.cache;
+  ObjectHash hash = nargs;
+  for (u32 i = 0; i < nargs; ++i) {
+    auto arg_hash = obj_hash_bare(args[i]);
+    if (!arg_hash) {
+      ++cache.misses;
+      return apply_callable(fun, args, nargs);
+    }
+    hash = hash_combine(hash, *arg_hash);
+  }
+  auto [it, end] = cache.index.equal_range(hash);
+  for (; it != end; ++it) {
+    auto &entry = *it->second;
+    if (entry.args.size() != nargs) continue;
+    bool equal = true;
+    for (u32 i = 0; i < nargs && equal; ++i) {
+      equal = keys_equal_bare(entry.args[i], args[i]);
+    }
+    if (!equal) continue;
+    ++cache.hits;
+    cache.entries.splice(cache.entries.begin(), cache.entries, it->second);
+    return entry.result;
+  }
+  ++cache.misses;
+  // the cache may change during the call, recursive ones fill it
+  auto *res = apply_callable(fun, args, nargs);
+  if (cache.capacity == 0) return res;
+  for (u32 i = 0; i < nargs; ++i) gc_write_barrier(memo, args[i]);
+  gc_write_barrier(memo, res);
+  cache.entries.push_front({hash, {args, args + nargs}, res});
+  cache.index.emplace(hash, cache.entries.begin());
+  evict_entries(cache, cache.capacity);
+  return res;
+}
+
+void memo_set_capacity(Object *memo, size_t capacity) {
+  auto &cache = *memo->val.memo_value.cache;
+  cache.capacity = capacity;
+  evict_entries(cache, capacity);
+}
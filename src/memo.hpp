@@ -0,0 +1,45 @@
+#ifndef MEMO_HPP
+#define MEMO_HPP
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "objects.hpp"
+#include "types.hpp"
+
+// Memoized functions (see memoize and defun-memo) wrap another function
+// and keep the results of its calls, by argument list, in a cache of at
+// most capacity entries. The least recently used entry is evicted to make
+// room for a new one. The arguments are looked up by structural hash (see
+// obj_hash_bare) and compared with keys_equal_bare; calls with arguments
+// that can't be hashed aren't cached.
+
+const size_t MEMO_DEFAULT_CAPACITY = 1024;
+
+struct MemoEntry {
+  ObjectHash hash;
+  std::vector<Object *> args;
+  Object *result;
+};
+
+struct MemoCache {
+  size_t capacity;
+  // the most recently used first
+  std::list<MemoEntry> entries;
+  std::unordered_multimap<ObjectHash, std::list<MemoEntry>::iterator> index;
+  u64 hits = 0;
+  u64 misses = 0;
+  u64 evictions = 0;
+};
+
+// The memoize built-in, the compiler calls it for defun-memo
+extern Object *memoize_builtin;
+
+Object *create_memo_fobj(Object *fun, size_t capacity);
+// Calls the memoized function with already evaluated arguments
+Object *memo_call(Object *memo, Object **args, u32 nargs);
+// Evicts the least recently used entries beyond the new capacity
+void memo_set_capacity(Object *memo, size_t capacity);
+
+#endif
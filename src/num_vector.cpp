@@ -0,0 +1,735 @@
+#include "num_vector.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+// SSE2 is always there on x86-64, AVX2 is checked for at run time
+#define VEC_X86
+#define VEC_AVX2 __attribute__((target("avx2")))
+#endif
+
+#include <algorithm>
+#include <string>
+
+bool vec_simd = true;
+
+Object *create_num_vector_obj(VecKind kind, size_t size) {
+  auto *res = new_object(ObjType::NumVector, OF_EVALUATED);
+  auto &v = res->val.vec_value;
+  v.kind = kind;
+  v.size = size;
+  if (kind == VecKind::I64) {
+    v.i64s = new i64[size]();
+  } else {
+    v.f64s = new double[size]();
+  }
+  heap_external_alloc(size * sizeof(i64));
+  return res;
+}
+
+std::string *num_vector_to_string(Object *vec) {
+  auto &v = vec->val.vec_value;
+  auto *res = new std::string(v.kind == VecKind::I64 ? "(i64vector"
+                                                     : "(f64vector");
+  for (size_t i = 0; i < v.size; ++i) {
+    *res += ' ';
+    if (v.kind == VecKind::I64) {
+      *res += std::to_string(v.i64s[i]);
+    } else {
+      *res += float_to_string(v.f64s[i]);
+    }
+  }
+  *res += ')';
+  return res;
+}
+
+// The elements of i64 vectors are fixnums, so are the results the
+// element-wise operations store. Sums of two fixnums always fit an i64.
+inline bool add_fixnums(i64 a, i64 b, i64 &res) {
+  res = a + b;
+  return fits_fixnum(res);
+}
+
+inline bool mul_fixnums(i64 a, i64 b, i64 &res) {
+  return !__builtin_mul_overflow(a, b, &res) && fits_fixnum(res);
+}
+
+#if defined(VEC_X86)
+
+inline bool use_avx2() {
+  static bool has_avx2 = __builtin_cpu_supports("avx2");
+  return vec_simd && has_avx2;
+}
+
+// The kernels go through the elements a register at a time and return how
+// many they did, the callers do the rest one by one. The integer kernels
+// stop where a result may not fit, or return 0 to have all of it done
+// again, and the callers find out with the overflow checks of their loops.
+
+VEC_AVX2 inline double hsum(__m256d v) {
+  __m128d lo = _mm_add_pd(_mm256_castpd256_pd128(v),
+                          _mm256_extractf128_pd(v, 1));
+  return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+}
+
+inline double hsum(__m128d v) {
+  return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+// Adds the lanes to res, false if that overflows
+template <size_t N>
+inline bool add_lanes(i64 const (&lanes)[N], i64 &res) {
+  for (auto lane : lanes) {
+    if (__builtin_add_overflow(res, lane, &res)) return false;
+  }
+  return true;
+}
+
+VEC_AVX2 inline bool hsum(__m256i v, i64 &res) {
+  i64 lanes[4];
+  _mm256_storeu_si256((__m256i *)lanes, v);
+  return add_lanes(lanes, res);
+}
+
+inline bool hsum(__m128i v, i64 &res) {
+  i64 lanes[2];
+  _mm_storeu_si128((__m128i *)lanes, v);
+  return add_lanes(lanes, res);
+}
+
+// Whether the sign bit of any lane is set
+VEC_AVX2 inline bool any_sign(__m256i v) {
+  return _mm256_movemask_pd(_mm256_castsi256_pd(v)) != 0;
+}
+
+inline bool any_sign(__m128i v) {
+  return _mm_movemask_pd(_mm_castsi128_pd(v)) != 0;
+}
+
+// The sign bit is set in the lanes that aren't fixnums, where the top two
+// bits differ
+VEC_AVX2 inline __m256i non_fixnum_bits(__m256i x) {
+  return _mm256_xor_si256(x, _mm256_slli_epi64(x, 1));
+}
+
+inline __m128i non_fixnum_bits(__m128i x) {
+  return _mm_xor_si128(x, _mm_slli_epi64(x, 1));
+}
+
+// The sign bit is set in the lanes where sum = a + b overflowed: a and b
+// have the same sign and sum the other one
+VEC_AVX2 inline __m256i add_overflow_bits(__m256i a, __m256i b, __m256i sum) {
+  return _mm256_and_si256(_mm256_xor_si256(sum, a), _mm256_xor_si256(sum, b));
+}
+
+inline __m128i add_overflow_bits(__m128i a, __m128i b, __m128i sum) {
+  return _mm_and_si128(_mm_xor_si128(sum, a), _mm_xor_si128(sum, b));
+}
+
+// Not zero in the lanes that aren't 32-bit integers. Products of those
+// are at most 2^62 in magnitude.
+VEC_AVX2 inline __m256i wide_bits(__m256i x) {
+  return _mm256_srli_epi64(_mm256_add_epi64(x, _mm256_set1_epi64x(1LL << 31)),
+                           32);
+}
+
+VEC_AVX2 inline bool any_set(__m256i v) { return !_mm256_testz_si256(v, v); }
+
+// Lane-wise 64-bit product: AVX2 only multiplies 32-bit halves, the high
+// halves of the cross products are shifted out anyway
+VEC_AVX2 inline __m256i mul_epi64(__m256i a, __m256i b) {
+  __m256i cross = _mm256_mullo_epi32(a, _mm256_shuffle_epi32(b, 0xB1));
+  __m256i cross_sums = _mm256_hadd_epi32(cross, _mm256_setzero_si256());
+  __m256i high = _mm256_shuffle_epi32(cross_sums, 0x73);
+  return _mm256_add_epi64(_mm256_mul_epu32(a, b), high);
+}
+
+VEC_AVX2 inline __m256i min_epi64(__m256i a, __m256i b) {
+  return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b));
+}
+
+VEC_AVX2 inline __m256i max_epi64(__m256i a, __m256i b) {
+  return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b));
+}
+
+VEC_AVX2 size_t add_avx2(double const *a, double const *b, double *out,
+                         size_t n) {
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(a + i),
+                                            _mm256_loadu_pd(b + i)));
+  }
+  return i;
+}
+
+size_t add_sse2(double const *a, double const *b, double *out, size_t n) {
+  size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    auto sum = _mm_add_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i));
+    _mm_storeu_pd(out + i, sum);
+  }
+  return i;
+}
+
+VEC_AVX2 size_t add_avx2(i64 const *a, i64 const *b, i64 *out, size_t n) {
+  size_t i = 0;
+  auto non_fixnums = _mm256_setzero_si256();
+  for (; i + 4 <= n; i += 4) {
+    auto va = _mm256_loadu_si256((__m256i const *)(a + i));
+    auto vb = _mm256_loadu_si256((__m256i const *)(b + i));
+    auto sum = _mm256_add_epi64(va, vb);
+    non_fixnums = _mm256_or_si256(non_fixnums, non_fixnum_bits(sum));
+    _mm256_storeu_si256((__m256i *)(out + i), sum);
+  }
+  return any_sign(non_fixnums) ? 0 : i;
+}
+
+size_t add_sse2(i64 const *a, i64 const *b, i64 *out, size_t n) {
+  size_t i = 0;
+  auto non_fixnums = _mm_setzero_si128();
+  for (; i + 2 <= n; i += 2) {
+    auto va = _mm_loadu_si128((__m128i const *)(a + i));
+    auto vb = _mm_loadu_si128((__m128i const *)(b + i));
+    auto sum = _mm_add_epi64(va, vb);
+    non_fixnums = _mm_or_si128(non_fixnums, non_fixnum_bits(sum));
+    _mm_storeu_si128((__m128i *)(out + i), sum);
+  }
+  return any_sign(non_fixnums) ? 0 : i;
+}
+
+VEC_AVX2 size_t mul_avx2(double const *a, double const *b, double *out,
+                         size_t n) {
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(a + i),
+                                            _mm256_loadu_pd(b + i)));
+  }
+  return i;
+}
+
+size_t mul_sse2(double const *a, double const *b, double *out, size_t n) {
+  size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    auto product = _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i));
+    _mm_storeu_pd(out + i, product);
+  }
+  return i;
+}
+
+// Blocks with wider factors are multiplied one by one, and 2^62, the
+// product of two -2^31, is caught after
+VEC_AVX2 size_t mul_avx2(i64 const *a, i64 const *b, i64 *out, size_t n) {
+  size_t i = 0;
+  auto non_fixnums = _mm256_setzero_si256();
+  for (; i + 4 <= n; i += 4) {
+    auto va = _mm256_loadu_si256((__m256i const *)(a + i));
+    auto vb = _mm256_loadu_si256((__m256i const *)(b + i));
+    if (any_set(_mm256_or_si256(wide_bits(va), wide_bits(vb)))) {
+      for (size_t j = i; j < i + 4; ++j) {
+        if (!mul_fixnums(a[j], b[j], out[j])) return j;
+      }
+      continue;
+    }
+    auto product = mul_epi64(va, vb);
+    non_fixnums = _mm256_or_si256(non_fixnums, non_fixnum_bits(product));
+    _mm256_storeu_si256((__m256i *)(out + i), product);
+  }
+  return any_sign(non_fixnums) ? 0 : i;
+}
+
+VEC_AVX2 size_t scale_avx2(double const *a, double k, double *out,
+                           size_t n) {
+  size_t i = 0;
+  auto vk = _mm256_set1_pd(k);
+  for (; i + 4 <= n; i += 4) {
+    _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(a + i), vk));
+  }
+  return i;
+}
+
+size_t scale_sse2(double const *a, double k, double *out, size_t n) {
+  size_t i = 0;
+  auto vk = _mm_set1_pd(k);
+  for (; i + 2 <= n; i += 2) {
+    _mm_storeu_pd(out + i, _mm_mul_pd(_mm_loadu_pd(a + i), vk));
+  }
+  return i;
+}
+
+// Like mul_avx2, a wider factor is multiplied one by one
+VEC_AVX2 size_t scale_avx2(i64 const *a, i64 k, i64 *out, size_t n) {
+  size_t i = 0;
+  if (k != (i32)k) return 0;
+  auto vk = _mm256_set1_epi64x(k);
+  auto non_fixnums = _mm256_setzero_si256();
+  for (; i + 4 <= n; i += 4) {
+    auto va = _mm256_loadu_si256((__m256i const *)(a + i));
+    if (any_set(wide_bits(va))) {
+      for (size_t j = i; j < i + 4; ++j) {
+        if (!mul_fixnums(a[j], k, out[j])) return j;
+      }
+      continue;
+    }
+    auto product = mul_epi64(va, vk);
+    non_fixnums = _mm256_or_si256(non_fixnums, non_fixnum_bits(product));
+    _mm256_storeu_si256((__m256i *)(out + i), product);
+  }
+  return any_sign(non_fixnums) ? 0 : i;
+}
+
+// Two accumulators, so that the additions of one don't wait for the other
+VEC_AVX2 size_t dot_avx2(double const *a, double const *b, size_t n,
+                         double &res) {
+  size_t i = 0;
+  auto acc0 = _mm256_setzero_pd();
+  auto acc1 = _mm256_setzero_pd();
+  for (; i + 8 <= n; i += 8) {
+    acc0 = _mm256_add_pd(
+        acc0, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(a + i + 4),
+                                             _mm256_loadu_pd(b + i + 4)));
+  }
+  res = hsum(_mm256_add_pd(acc0, acc1));
+  return i;
+}
+
+size_t dot_sse2(double const *a, double const *b, size_t n, double &res) {
+  size_t i = 0;
+  auto acc0 = _mm_setzero_pd();
+  auto acc1 = _mm_setzero_pd();
+  for (; i + 4 <= n; i += 4) {
+    acc0 = _mm_add_pd(acc0,
+                      _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+    acc1 = _mm_add_pd(
+        acc1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+  }
+  res = hsum(_mm_add_pd(acc0, acc1));
+  return i;
+}
+
+// Blocks with wider factors are added up one by one in wide_sum
+VEC_AVX2 size_t dot_avx2(i64 const *a, i64 const *b, size_t n, i64 &res) {
+  size_t i = 0;
+  auto acc = _mm256_setzero_si256();
+  auto overflows = _mm256_setzero_si256();
+  i64 wide_sum = 0;
+  for (; i + 4 <= n; i += 4) {
+    auto va = _mm256_loadu_si256((__m256i const *)(a + i));
+    auto vb = _mm256_loadu_si256((__m256i const *)(b + i));
+    if (any_set(_mm256_or_si256(wide_bits(va), wide_bits(vb)))) {
+      for (size_t j = i; j < i + 4; ++j) {
+        i64 product;
+        if (__builtin_mul_overflow(a[j], b[j], &product) ||
+            __builtin_add_overflow(wide_sum, product, &wide_sum)) {
+          return 0;
+        }
+      }
+      continue;
+    }
+    auto product = mul_epi64(va, vb);
+    auto sum = _mm256_add_epi64(acc, product);
+    overflows = _mm256_or_si256(overflows, add_overflow_bits(acc, product, sum));
+    acc = sum;
+  }
+  res = wide_sum;
+  if (any_sign(overflows) || !hsum(acc, res)) {
+    res = 0;
+    return 0;
+  }
+  return i;
+}
+
+VEC_AVX2 size_t sum_avx2(double const *a, size_t n, double &res) {
+  size_t i = 0;
+  auto acc0 = _mm256_setzero_pd();
+  auto acc1 = _mm256_setzero_pd();
+  for (; i + 8 <= n; i += 8) {
+    acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(a + i));
+    acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(a + i + 4));
+  }
+  res = hsum(_mm256_add_pd(acc0, acc1));
+  return i;
+}
+
+size_t sum_sse2(double const *a, size_t n, double &res) {
+  size_t i = 0;
+  auto acc0 = _mm_setzero_pd();
+  auto acc1 = _mm_setzero_pd();
+  for (; i + 4 <= n; i += 4) {
+    acc0 = _mm_add_pd(acc0, _mm_loadu_pd(a + i));
+    acc1 = _mm_add_pd(acc1, _mm_loadu_pd(a + i + 2));
+  }
+  res = hsum(_mm_add_pd(acc0, acc1));
+  return i;
+}
+
+VEC_AVX2 size_t sum_avx2(i64 const *a, size_t n, i64 &res) {
+  size_t i = 0;
+  auto acc = _mm256_setzero_si256();
+  auto overflows = _mm256_setzero_si256();
+  for (; i + 4 <= n; i += 4) {
+    auto x = _mm256_loadu_si256((__m256i const *)(a + i));
+    auto sum = _mm256_add_epi64(acc, x);
+    overflows = _mm256_or_si256(overflows, add_overflow_bits(acc, x, sum));
+    acc = sum;
+  }
+  res = 0;
+  if (any_sign(overflows) || !hsum(acc, res)) {
+    res = 0;
+    return 0;
+  }
+  return i;
+}
+
+size_t sum_sse2(i64 const *a, size_t n, i64 &res) {
+  size_t i = 0;
+  auto acc = _mm_setzero_si128();
+  auto overflows = _mm_setzero_si128();
+  for (; i + 2 <= n; i += 2) {
+    auto x = _mm_loadu_si128((__m128i const *)(a + i));
+    auto sum = _mm_add_epi64(acc, x);
+    overflows = _mm_or_si128(overflows, add_overflow_bits(acc, x, sum));
+    acc = sum;
+  }
+  res = 0;
+  if (any_sign(overflows) || !hsum(acc, res)) {
+    res = 0;
+    return 0;
+  }
+  return i;
+}
+
+// The minimum (or maximum) of the lanes, starting from the first elements.
+// n is at least a register's worth.
+VEC_AVX2 size_t min_avx2(double const *a, size_t n, double &res) {
+  auto acc = _mm256_loadu_pd(a);
+  size_t i = 4;
+  for (; i + 4 <= n; i += 4) acc = _mm256_min_pd(acc, _mm256_loadu_pd(a + i));
+  double lanes[4];
+  _mm256_storeu_pd(lanes, acc);
+  res = *std::min_element(lanes, lanes + 4);
+  return i;
+}
+
+size_t min_sse2(double const *a, size_t n, double &res) {
+  auto acc = _mm_loadu_pd(a);
+  size_t i = 2;
+  for (; i + 2 <= n; i += 2) acc = _mm_min_pd(acc, _mm_loadu_pd(a + i));
+  res = _mm_cvtsd_f64(_mm_min_sd(acc, _mm_unpackhi_pd(acc, acc)));
+  return i;
+}
+
+VEC_AVX2 size_t max_avx2(double const *a, size_t n, double &res) {
+  auto acc = _mm256_loadu_pd(a);
+  size_t i = 4;
+  for (; i + 4 <= n; i += 4) acc = _mm256_max_pd(acc, _mm256_loadu_pd(a + i));
+  double lanes[4];
+  _mm256_storeu_pd(lanes, acc);
+  res = *std::max_element(lanes, lanes + 4);
+  return i;
+}
+
+size_t max_sse2(double const *a, size_t n, double &res) {
+  auto acc = _mm_loadu_pd(a);
+  size_t i = 2;
+  for (; i + 2 <= n; i += 2) acc = _mm_max_pd(acc, _mm_loadu_pd(a + i));
+  res = _mm_cvtsd_f64(_mm_max_sd(acc, _mm_unpackhi_pd(acc, acc)));
+  return i;
+}
+
+VEC_AVX2 size_t min_avx2(i64 const *a, size_t n, i64 &res) {
+  auto acc = _mm256_loadu_si256((__m256i const *)a);
+  size_t i = 4;
+  for (; i + 4 <= n; i += 4) {
+    acc = min_epi64(acc, _mm256_loadu_si256((__m256i const *)(a + i)));
+  }
+  i64 lanes[4];
+  _mm256_storeu_si256((__m256i *)lanes, acc);
+  res = *std::min_element(lanes, lanes + 4);
+  return i;
+}
+
+VEC_AVX2 size_t max_avx2(i64 const *a, size_t n, i64 &res) {
+  auto acc = _mm256_loadu_si256((__m256i const *)a);
+  size_t i = 4;
+  for (; i + 4 <= n; i += 4) {
+    acc = max_epi64(acc, _mm256_loadu_si256((__m256i const *)(a + i)));
+  }
+  i64 lanes[4];
+  _mm256_storeu_si256((__m256i *)lanes, acc);
+  res = *std::max_element(lanes, lanes + 4);
+  return i;
+}
+
+// Prefix sums of a register: the lanes are added to the ones 1, then 2
+// places up, then the sum of the elements before is added to all of them
+VEC_AVX2 size_t prefix_sum_avx2(double const *a, double *out, size_t n,
+                                double &carry) {
+  size_t i = 0;
+  auto vcarry = _mm256_set1_pd(carry);
+  auto zero = _mm256_setzero_pd();
+  for (; i + 4 <= n; i += 4) {
+    auto x = _mm256_loadu_pd(a + i);
+    auto up1 = _mm256_blend_pd(_mm256_permute4x64_pd(x, 0x90), zero, 0x1);
+    x = _mm256_add_pd(x, up1);
+    x = _mm256_add_pd(x, _mm256_permute2f128_pd(x, x, 0x08));
+    x = _mm256_add_pd(x, vcarry);
+    _mm256_storeu_pd(out + i, x);
+    vcarry = _mm256_permute4x64_pd(x, 0xFF);
+  }
+  carry = _mm_cvtsd_f64(_mm256_castpd256_pd128(vcarry));
+  return i;
+}
+
+// The sums are exact modulo 2^64, and the first one past the fixnums is
+// less than 2^63 in magnitude, so it's caught
+VEC_AVX2 size_t prefix_sum_avx2(i64 const *a, i64 *out, size_t n,
+                                i64 &carry) {
+  size_t i = 0;
+  auto vcarry = _mm256_set1_epi64x(carry);
+  auto zero = _mm256_setzero_si256();
+  auto non_fixnums = zero;
+  for (; i + 4 <= n; i += 4) {
+    auto x = _mm256_loadu_si256((__m256i const *)(a + i));
+    auto up1 =
+        _mm256_blend_epi32(_mm256_permute4x64_epi64(x, 0x90), zero, 0x03);
+    x = _mm256_add_epi64(x, up1);
+    x = _mm256_add_epi64(x, _mm256_permute2x128_si256(x, x, 0x08));
+    x = _mm256_add_epi64(x, vcarry);
+    non_fixnums = _mm256_or_si256(non_fixnums, non_fixnum_bits(x));
+    _mm256_storeu_si256((__m256i *)(out + i), x);
+    vcarry = _mm256_permute4x64_epi64(x, 0xFF);
+  }
+  if (any_sign(non_fixnums)) return 0;
+  carry = _mm_cvtsi128_si64(_mm256_castsi256_si128(vcarry));
+  return i;
+}
+
+#endif
+
+bool vec_add(i64 const *a, i64 const *b, i64 *out, size_t n) {
+  size_t i = 0;
+#if defined(VEC_X86)
+  if (use_avx2()) {
+    i = add_avx2(a, b, out, n);
+  } else if (vec_simd) {
+    i = add_sse2(a, b, out, n);
+  }
+#endif
+  for (; i < n; ++i) {
+    if (!add_fixnums(a[i], b[i], out[i])) return false;
+  }
+  return true;
+}
+
+void vec_add(double const *a, double const *b, double *out, size_t n) {
+  size_t i = 0;
+#if defined(VEC_X86)
+  if (use_avx2()) {
+    i = add_avx2(a, b, out, n);
+  } else if (vec_simd) {
+    i = add_sse2(a, b, out, n);
+  }
+#endif
+  for (; i < n; ++i) out[i] = a[i] + b[i];
+}
+
+bool vec_mul(i64 const *a, i64 const *b, i64 *out, size_t n) {
+  size_t i = 0;
+#if defined(VEC_X86)
+  // SSE2 has no 64-bit multiplication
+  if (use_avx2()) i = mul_avx2(a, b, out, n);
+#endif
+  for (; i < n; ++i) {
+    if (!mul_fixnums(a[i], b[i], out[i])) return false;
+  }
+  return true;
+}
+
+void vec_mul(double const *a, double const *b, double *out, size_t n) {
+  size_t i = 0;
+#if defined(VEC_X86)
+  if (use_avx2()) {
+    i = mul_avx2(a, b, out, n);
+  } else if (vec_simd) {
+    i = mul_sse2(a, b, out, n);
+  }
+#endif
+  for (; i < n; ++i) out[i] = a[i] * b[i];
+}
+
+bool vec_scale(i64 const *a, i64 k, i64 *out, size_t n) {
+  size_t i = 0;
+#if defined(VEC_X86)
+  if (use_avx2()) i = scale_avx2(a, k, out, n);
+#endif
+  for (; i < n; ++i) {
+    if (!mul_fixnums(a[i], k, out[i])) return false;
+  }
+  return true;
+}
+
+void vec_scale(double const *a, double k, double *out, size_t n) {
+  size_t i = 0;
+#if defined(VEC_X86)
+  if (use_avx2()) {
+    i = scale_avx2(a, k, out, n);
+  } else if (vec_simd) {
+    i = scale_sse2(a, k, out, n);
+  }
+#endif
+  for (; i < n; ++i) out[i] = a[i] * k;
+}
+
+bool vec_prefix_sum(i64 const *a, i64 *out, size_t n) {
+  size_t i = 0;
+  i64 carry = 0;
+#if defined(VEC_X86)
+  if (use_avx2()) i = prefix_sum_avx2(a, out, n, carry);
+#endif
+  for (; i < n; ++i) {
+    if (!add_fixnums(carry, a[i], carry)) return false;
+    out[i] = carry;
+  }
+  return true;
+}
+
+void vec_prefix_sum(double const *a, double *out, size_t n) {
+  size_t i = 0;
+  double carry = 0;
+#if defined(VEC_X86)
+  if (use_avx2()) i = prefix_sum_avx2(a, out, n, carry);
+#endif
+  for (; i < n; ++i) out[i] = carry += a[i];
+}
+
+bool vec_dot(i64 const *a, i64 const *b, size_t n, i64 &res) {
+  size_t i = 0;
+  res = 0;
+#if defined(VEC_X86)
+  if (use_avx2()) i = dot_avx2(a, b, n, res);
+#endif
+  for (; i < n; ++i) {
+    i64 product;
+    if (__builtin_mul_overflow(a[i], b[i], &product) ||
+        __builtin_add_overflow(res, product, &res)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+double vec_dot(double const *a, double const *b, size_t n) {
+  size_t i = 0;
+  double res = 0;
+#if defined(VEC_X86)
+  if (use_avx2()) {
+    i = dot_avx2(a, b, n, res);
+  } else if (vec_simd) {
+    i = dot_sse2(a, b, n, res);
+  }
+#endif
+  for (; i < n; ++i) res += a[i] * b[i];
+  return res;
+}
+
+bool vec_sum(i64 const *a, size_t n, i64 &res) {
+  size_t i = 0;
+  res = 0;
+#if defined(VEC_X86)
+  if (use_avx2()) {
+    i = sum_avx2(a, n, res);
+  } else if (vec_simd) {
+    i = sum_sse2(a, n, res);
+  }
+#endif
+  for (; i < n; ++i) {
+    if (__builtin_add_overflow(res, a[i], &res)) return false;
+  }
+  return true;
+}
+
+Object *vec_sum_obj(Object *vec) {
+  auto &v = vec->val.vec_value;
+  i64 sum;
+  if (vec_sum(v.i64s, v.size, sum)) return create_int_obj(sum);
+  auto *res = create_num_obj(0);
+  for (size_t i = 0; i < v.size; ++i) {
+    res = num_add(res, create_num_obj(v.i64s[i]));
+  }
+  return res;
+}
+
+Object *vec_dot_obj(Object *a, Object *b) {
+  auto &va = a->val.vec_value;
+  auto &vb = b->val.vec_value;
+  i64 dot;
+  if (vec_dot(va.i64s, vb.i64s, va.size, dot)) return create_int_obj(dot);
+  auto *res = create_num_obj(0);
+  for (size_t i = 0; i < va.size; ++i) {
+    res = num_add(res, num_mul(create_num_obj(va.i64s[i]),
+                               create_num_obj(vb.i64s[i])));
+  }
+  return res;
+}
+
+double vec_sum(double const *a, size_t n) {
+  size_t i = 0;
+  double res = 0;
+#if defined(VEC_X86)
+  if (use_avx2()) {
+    i = sum_avx2(a, n, res);
+  } else if (vec_simd) {
+    i = sum_sse2(a, n, res);
+  }
+#endif
+  for (; i < n; ++i) res += a[i];
+  return res;
+}
+
+i64 vec_min(i64 const *a, size_t n) {
+  size_t i = 1;
+  i64 res = a[0];
+#if defined(VEC_X86)
+  if (use_avx2() && n >= 4) i = min_avx2(a, n, res);
+#endif
+  for (; i < n; ++i) res = std::min(res, a[i]);
+  return res;
+}
+
+double vec_min(double const *a, size_t n) {
+  size_t i = 1;
+  double res = a[0];
+#if defined(VEC_X86)
+  if (use_avx2() && n >= 4) {
+    i = min_avx2(a, n, res);
+  } else if (vec_simd && n >= 2) {
+    i = min_sse2(a, n, res);
+  }
+#endif
+  for (; i < n; ++i) res = std::min(res, a[i]);
+  return res;
+}
+
+i64 vec_max(i64 const *a, size_t n) {
+  size_t i = 1;
+  i64 res = a[0];
+#if defined(VEC_X86)
+  if (use_avx2() && n >= 4) i = max_avx2(a, n, res);
+#endif
+  for (; i < n; ++i) res = std::max(res, a[i]);
+  return res;
+}
+
+double vec_max(double const *a, size_t n) {
+  size_t i = 1;
+  double res = a[0];
+#if defined(VEC_X86)
+  if (use_avx2() && n >= 4) {
+    i = max_avx2(a, n, res);
+  } else if (vec_simd && n >= 2) {
+    i = max_sse2(a, n, res);
+  }
+#endif
+  for (; i < n; ++i) res = std::max(res, a[i]);
+  return res;
+}
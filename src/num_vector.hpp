@@ -0,0 +1,76 @@
+#ifndef NUM_VECTOR_HPP
+#define NUM_VECTOR_HPP
+
+#include <stddef.h>
+
+#include "numbers.hpp"
+#include "objects.hpp"
+#include "types.hpp"
+
+// Numeric vectors pack their elements in one array of 64-bit integers
+// (make-i64vector) or doubles (make-f64vector) instead of a list of
+// objects. The element-wise operations, reductions and prefix sums run
+// native kernels over the array: with AVX2 where the CPU has it (picked at
+// run time), SSE2 otherwise on x86-64, plain loops elsewhere or with
+// --no-simd.
+
+// use the SIMD kernels, see --no-simd
+extern bool vec_simd;
+
+Object *create_num_vector_obj(VecKind kind, size_t size);
+
+inline size_t vec_length(Object const *vec) { return vec->val.vec_value.size; }
+
+inline VecKind vec_kind(Object const *vec) { return vec->val.vec_value.kind; }
+
+inline Object *vec_ref(Object *vec, size_t i) {
+  auto &v = vec->val.vec_value;
+  if (v.kind == VecKind::I64) return create_int_obj(v.i64s[i]);
+  return create_float_obj(v.f64s[i]);
+}
+
+// i64 vectors hold fixnums, f64 ones any number converted to a double
+inline bool vec_accepts(VecKind kind, Object *value) {
+  if (kind == VecKind::I64) return obj_type(value) == ObjType::Number;
+  return is_number(value);
+}
+
+// value must be one vec_accepts
+inline void vec_set(Object *vec, size_t i, Object *value) {
+  auto &v = vec->val.vec_value;
+  if (v.kind == VecKind::I64) {
+    v.i64s[i] = num_value(value);
+  } else {
+    v.f64s[i] = num_to_double(value);
+  }
+}
+
+std::string *num_vector_to_string(Object *vec);
+
+// out[i] = a[i] + b[i], out[i] = a[i] * b[i], out[i] = a[i] * k. The i64
+// ones return false, with out partly written, when a result isn't a
+// fixnum.
+bool vec_add(i64 const *a, i64 const *b, i64 *out, size_t n);
+void vec_add(double const *a, double const *b, double *out, size_t n);
+bool vec_mul(i64 const *a, i64 const *b, i64 *out, size_t n);
+void vec_mul(double const *a, double const *b, double *out, size_t n);
+bool vec_scale(i64 const *a, i64 k, i64 *out, size_t n);
+void vec_scale(double const *a, double k, double *out, size_t n);
+// out[i] = a[0] + ... + a[i], out may be a
+bool vec_prefix_sum(i64 const *a, i64 *out, size_t n);
+void vec_prefix_sum(double const *a, double *out, size_t n);
+// The i64 ones return false when the result overflows an i64
+bool vec_dot(i64 const *a, i64 const *b, size_t n, i64 &res);
+double vec_dot(double const *a, double const *b, size_t n);
+bool vec_sum(i64 const *a, size_t n, i64 &res);
+double vec_sum(double const *a, size_t n);
+// Of i64 vectors, as bignums past the i64s
+Object *vec_dot_obj(Object *a, Object *b);
+Object *vec_sum_obj(Object *vec);
+// of at least one element
+i64 vec_min(i64 const *a, size_t n);
+double vec_min(double const *a, size_t n);
+i64 vec_max(i64 const *a, size_t n);
+double vec_max(double const *a, size_t n);
+
+#endif
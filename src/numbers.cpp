@@ -0,0 +1,320 @@
+#include "numbers.hpp"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <algorithm>
+
+// Results of ** past this many bits are reported instead of computed
+const u64 MAX_POW_BITS = (u64)1 << 32;
+
+// The fixnum of a magnitude with no leading zeros, nullptr if it's too big
+Object *fixnum_of(LimbSpan magnitude, bool negative) {
+  if (magnitude.size() > 2) return nullptr;
+  u64 m = magnitude.empty() ? 0 : magnitude[0];
+  if (magnitude.size() == 2) m |= (u64)magnitude[1] << 32;
+  if (!negative && m <= (u64)FIXNUM_MAX) return create_num_obj((i64)m);
+  if (negative && m <= (u64)FIXNUM_MAX + 1) return create_num_obj(-(i64)m);
+  return nullptr;
+}
+
+Object *create_bigint_obj(Limbs &&magnitude, bool negative) {
+  if (auto *res = fixnum_of(magnitude, negative)) return res;
+  auto *res = new_object(ObjType::BigInt, OF_EVALUATED);
+  heap_external_alloc(magnitude.size() * sizeof(u32));
+  res->val.big_value.limbs = new Limbs(std::move(magnitude));
+  res->val.big_value.negative = negative;
+  return res;
+}
+
+Object *create_bigint_obj(LimbSpan magnitude, bool negative) {
+  magnitude = limbs_significant(magnitude);
+  if (auto *res = fixnum_of(magnitude, negative)) return res;
+  return create_bigint_obj(Limbs(magnitude.begin(), magnitude.end()),
+                           negative);
+}
+
+Object *create_int_obj(i64 v) {
+  if (fits_fixnum(v)) return create_num_obj(v);
+  auto magnitude = limbs_from_u64(v < 0 ? 0 - (u64)v : (u64)v);
+  return create_bigint_obj(std::move(magnitude), v < 0);
+}
+
+Object *create_float_obj(double v) {
+  auto *res = new_object(ObjType::Float, OF_EVALUATED);
+  res->val.d_value = v;
+  return res;
+}
+
+// Sign and magnitude of an integer
+struct IntParts {
+  bool negative;
+  LimbSpan magnitude;
+};
+
+// The limbs of fixnums go in buf
+IntParts int_parts(Object *num, u32 (&buf)[2]) {
+  if (is_fixnum(num)) {
+    i64 v = num_value(num);
+    u64 m = v < 0 ? 0 - (u64)v : (u64)v;
+    buf[0] = (u32)m;
+    buf[1] = (u32)(m >> 32);
+    return {v < 0, limbs_significant({buf, 2})};
+  }
+  auto &big = num->val.big_value;
+  return {big.negative, *big.limbs};
+}
+
+double num_to_double(Object *num) {
+  switch (obj_type(num)) {
+    case ObjType::Number: {
+      return (double)num_value(num);
+    } break;
+    case ObjType::BigInt: {
+      auto &big = num->val.big_value;
+      double res = limbs_to_double(*big.limbs);
+      return big.negative ? -res : res;
+    } break;
+    default: {
+      return float_value(num);
+    } break;
+  }
+}
+
+Object *parse_number(std::string_view text) {
+  bool negative = !text.empty() && text[0] == '-';
+  auto digits = text.substr(negative);
+  if (digits.empty() || !isdigit(digits[0])) return nullptr;
+  if (text.find_first_of(".eE") != std::string_view::npos) {
+    std::string s(text);
+    char *end;
+    double v = strtod(s.c_str(), &end);
+    if (end != s.c_str() + s.size()) return nullptr;
+    return create_float_obj(v);
+  }
+  if (digits.find_first_not_of("0123456789") != std::string_view::npos) {
+    return nullptr;
+  }
+  // 18 digits always fit in an i64
+  if (digits.size() <= 18) {
+    i64 v = 0;
+    for (char ch : digits) v = v * 10 + (ch - '0');
+    return create_int_obj(negative ? -v : v);
+  }
+  return create_bigint_obj(limbs_from_decimal(digits), negative);
+}
+
+std::string float_to_string(double v) {
+  auto res = format("{}", v);
+  if (res.find_first_of(".en") == std::string::npos) res += ".0";
+  return res;
+}
+
+std::string *number_to_string(Object *num) {
+  if (obj_type(num) == ObjType::Float) {
+    return new std::string(float_to_string(float_value(num)));
+  }
+  auto &big = num->val.big_value;
+  auto *res = new std::string(big.negative ? "-" : "");
+  *res += limbs_to_decimal(*big.limbs);
+  return res;
+}
+
+ObjectHash number_hash(Object *num) {
+  // hashes keys, where numbers of different types differ (see
+  // keys_equal_bare), so floats don't hash as the integers they equal
+  if (obj_type(num) == ObjType::Float) {
+    return hash_combine((u64)ObjType::Float,
+                        std::hash<double>{}(float_value(num)));
+  }
+  auto &big = num->val.big_value;
+  u64 res = hash_combine((u64)ObjType::BigInt, big.negative);
+  for (auto limb : LimbSpan(*big.limbs)) res = hash_combine(res, limb);
+  return res;
+}
+
+// num_compare of an integer and a double
+int compare_int_double(Object *num, double d) {
+  if (isnan(d)) return NUM_UNORDERED;
+  if (is_fixnum(num)) {
+    i64 v = num_value(num);
+    // the bounds of the fixnums are powers of 2, exact doubles
+    if (d > (double)FIXNUM_MAX) return -1;
+    if (d < (double)FIXNUM_MIN) return 1;
+    double whole = trunc(d);
+    auto w = (i64)whole;
+    if (v != w) return v < w ? -1 : 1;
+    return d > whole ? -1 : (d < whole ? 1 : 0);
+  }
+  auto &big = num->val.big_value;
+  int sign = big.negative ? -1 : 1;
+  // bignums are past the fixnums, so only a double that is too can be
+  // equal, and it holds an integer
+  if (isinf(d)) return d > 0 ? -1 : 1;
+  if (fabs(d) < -(double)FIXNUM_MIN) return sign;
+  if (big.negative != (d < 0)) return sign;
+  auto d_magnitude = limbs_from_double(d);
+  return sign * limbs_cmp(*big.limbs, d_magnitude);
+}
+
+int num_compare(Object *a, Object *b) {
+  if (is_fixnum(a) && is_fixnum(b)) {
+    return num_value(a) < num_value(b) ? -1 : num_value(a) > num_value(b);
+  }
+  bool a_float = obj_type(a) == ObjType::Float;
+  bool b_float = obj_type(b) == ObjType::Float;
+  if (a_float && b_float) {
+    double x = float_value(a), y = float_value(b);
+    if (isnan(x) || isnan(y)) return NUM_UNORDERED;
+    return x < y ? -1 : x > y;
+  }
+  if (b_float) return compare_int_double(a, float_value(b));
+  if (a_float) {
+    int res = compare_int_double(b, float_value(a));
+    return res == NUM_UNORDERED ? res : -res;
+  }
+  u32 a_buf[2], b_buf[2];
+  auto x = int_parts(a, a_buf);
+  auto y = int_parts(b, b_buf);
+  if (x.negative != y.negative) return x.negative ? -1 : 1;
+  int res = limbs_cmp(x.magnitude, y.magnitude);
+  return x.negative ? -res : res;
+}
+
+bool either_float(Object *a, Object *b) {
+  return obj_type(a) == ObjType::Float || obj_type(b) == ObjType::Float;
+}
+
+bool expect_numbers(char const *opname, Object *a, Object *b) {
+  if (is_number(a) && is_number(b)) return true;
+  error_binop_not_defined(opname, a, b);
+  return false;
+}
+
+bool is_zero(IntParts const &num) { return num.magnitude.empty(); }
+
+Object *int_add(IntParts a, IntParts b) {
+  if (a.negative == b.negative) {
+    return create_bigint_obj(limbs_add(a.magnitude, b.magnitude), a.negative);
+  }
+  int cmp = limbs_cmp(a.magnitude, b.magnitude);
+  if (cmp == 0) return create_num_obj(0);
+  if (cmp > 0) {
+    return create_bigint_obj(limbs_sub(a.magnitude, b.magnitude),
+                             a.negative);
+  }
+  return create_bigint_obj(limbs_sub(b.magnitude, a.magnitude), b.negative);
+}
+
+Object *num_add(Object *a, Object *b) {
+  if (!expect_numbers("Addition", a, b)) return nil_obj;
+  if (is_fixnum(a) && is_fixnum(b)) {
+    return create_int_obj(num_value(a) + num_value(b));
+  }
+  if (either_float(a, b)) {
+    return create_float_obj(num_to_double(a) + num_to_double(b));
+  }
+  u32 a_buf[2], b_buf[2];
+  return int_add(int_parts(a, a_buf), int_parts(b, b_buf));
+}
+
+Object *num_sub(Object *a, Object *b) {
+  if (!expect_numbers("Substraction", a, b)) return nil_obj;
+  if (is_fixnum(a) && is_fixnum(b)) {
+    return create_int_obj(num_value(a) - num_value(b));
+  }
+  if (either_float(a, b)) {
+    return create_float_obj(num_to_double(a) - num_to_double(b));
+  }
+  u32 a_buf[2], b_buf[2];
+  auto y = int_parts(b, b_buf);
+  y.negative = !y.negative;
+  return int_add(int_parts(a, a_buf), y);
+}
+
+Object *num_mul(Object *a, Object *b) {
+  if (!expect_numbers("Multiplication", a, b)) return nil_obj;
+  if (either_float(a, b)) {
+    return create_float_obj(num_to_double(a) * num_to_double(b));
+  }
+  u32 a_buf[2], b_buf[2];
+  auto x = int_parts(a, a_buf);
+  auto y = int_parts(b, b_buf);
+  return create_bigint_obj(limbs_mul(x.magnitude, y.magnitude),
+                           x.negative != y.negative);
+}
+
+// Truncated quotient or remainder of two integers
+Object *int_divmod(Object *a, Object *b, bool want_quot) {
+  u32 a_buf[2], b_buf[2];
+  auto x = int_parts(a, a_buf);
+  auto y = int_parts(b, b_buf);
+  if (is_zero(y)) {
+    error_msg("Division by zero");
+    return nil_obj;
+  }
+  Limbs quot, rem;
+  limbs_divmod(x.magnitude, y.magnitude, quot, rem);
+  if (want_quot) {
+    return create_bigint_obj(std::move(quot), x.negative != y.negative);
+  }
+  return create_bigint_obj(std::move(rem), x.negative);
+}
+
+Object *num_div(Object *a, Object *b) {
+  if (!expect_numbers("Division", a, b)) return nil_obj;
+  if (either_float(a, b)) {
+    return create_float_obj(num_to_double(a) / num_to_double(b));
+  }
+  return int_divmod(a, b, true);
+}
+
+Object *num_rem(Object *a, Object *b) {
+  if (!expect_numbers("Remainder", a, b)) return nil_obj;
+  if (either_float(a, b)) {
+    return create_float_obj(fmod(num_to_double(a), num_to_double(b)));
+  }
+  return int_divmod(a, b, false);
+}
+
+Object *num_pow(Object *a, Object *b) {
+  if (!expect_numbers("Power", a, b)) return nil_obj;
+  if (either_float(a, b) || obj_type(b) == ObjType::BigInt ||
+      num_value(b) < 0) {
+    return create_float_obj(pow(num_to_double(a), num_to_double(b)));
+  }
+  u64 exp = num_value(b);
+  // by squaring, in fixnums until it overflows
+  if (is_fixnum(a)) {
+    i64 base = num_value(a);
+    i64 res = 1;
+    u64 e = exp;
+    bool overflow = false;
+    while (e != 0 && !overflow) {
+      if (e & 1) overflow = __builtin_mul_overflow(res, base, &res);
+      e >>= 1;
+      if (e != 0 && !overflow) {
+        overflow = __builtin_mul_overflow(base, base, &base);
+      }
+    }
+    if (!overflow) return create_int_obj(res);
+  }
+  u32 a_buf[2];
+  auto x = int_parts(a, a_buf);
+  if (x.magnitude.size() == 1 && x.magnitude[0] == 1) {
+    return create_num_obj(x.negative && (exp & 1) ? -1 : 1);
+  }
+  if (exp > MAX_POW_BITS / (x.magnitude.size() * 32)) {
+    error_msg(format("Power: the result of ** would have over {} bits",
+                     MAX_POW_BITS));
+    return nil_obj;
+  }
+  Limbs res{1};
+  Limbs base(x.magnitude.begin(), x.magnitude.end());
+  while (exp != 0) {
+    if (exp & 1) res = limbs_mul(res, base);
+    exp >>= 1;
+    if (exp != 0) base = limbs_mul(base, base);
+  }
+  return create_bigint_obj(std::move(res), x.negative && (num_value(b) & 1));
+}
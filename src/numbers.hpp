@@ -0,0 +1,89 @@
+#ifndef NUMBERS_HPP
+#define NUMBERS_HPP
+
+#include <string>
+#include <string_view>
+
+#include "bignum.hpp"
+#include "objects.hpp"
+
+// The numeric tower. Integers are fixnums (immediates, see objects.hpp)
+// while they fit in 63 bits and BigInt objects past that: the arithmetic on
+// fixnums checks for overflow and promotes the result, the one on bignums
+// demotes it back once it fits. Floats are boxed doubles, read from the
+// literals with a point or an exponent. An operation with a float and an
+// integer gives a float; integer division truncates.
+
+inline bool is_number(Object const *o) {
+  auto ot = obj_type(o);
+  return ot == ObjType::Number || ot == ObjType::BigInt ||
+         ot == ObjType::Float;
+}
+
+// A fixnum, or a bignum if v doesn't fit in one
+Object *create_int_obj(i64 v);
+// A fixnum if the integer fits in one
+Object *create_bigint_obj(LimbSpan magnitude, bool negative);
+// Same, taking the limbs, which must have no leading zeros
+Object *create_bigint_obj(Limbs &&magnitude, bool negative);
+Object *create_float_obj(double v);
+
+inline double float_value(Object const *o) { return o->val.d_value; }
+
+// Rounded to the nearest double for the integers
+double num_to_double(Object *num);
+
+// The number a literal reads as, nullptr if the text isn't one
+Object *parse_number(std::string_view text);
+
+// Shortest text that reads back as the same double, with a point or an
+// exponent so that it doesn't read as an integer
+std::string float_to_string(double v);
+// Of bignums and floats
+std::string *number_to_string(Object *num);
+
+// Returned by num_compare when either number is a NaN
+const int NUM_UNORDERED = 2;
+// -1, 0 or 1 as a is less than, equal to or greater than b, exactly even
+// between floats and integers
+int num_compare(Object *a, Object *b);
+
+// Arithmetic on any two numbers, errors for other objects. The integer
+// divisions report a division by zero.
+Object *num_add(Object *a, Object *b);
+Object *num_sub(Object *a, Object *b);
+Object *num_mul(Object *a, Object *b);
+Object *num_div(Object *a, Object *b);
+Object *num_rem(Object *a, Object *b);
+Object *num_pow(Object *a, Object *b);
+
+// The built-ins, with the fixnum cases that don't overflow inline
+
+inline Object *objects_mul(Object *a, Object *b) {
+  i64 res;
+  if (is_fixnum(a) && is_fixnum(b) &&
+      !__builtin_mul_overflow(num_value(a), num_value(b), &res) &&
+      fits_fixnum(res)) {
+    return create_num_obj(res);
+  }
+  return num_mul(a, b);
+}
+
+inline Object *objects_div(Object *a, Object *b) {
+  // FIXNUM_MIN / -1 is the only quotient that doesn't fit
+  if (is_fixnum(a) && is_fixnum(b) && num_value(b) > 0) {
+    return create_num_obj(num_value(a) / num_value(b));
+  }
+  return num_div(a, b);
+}
+
+inline Object *objects_rem(Object *a, Object *b) {
+  if (is_fixnum(a) && is_fixnum(b) && num_value(b) != 0) {
+    return create_num_obj(num_value(a) % num_value(b));
+  }
+  return num_rem(a, b);
+}
+
+inline Object *objects_pow(Object *a, Object *b) { return num_pow(a, b); }
+
+#endif
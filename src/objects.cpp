@@ -7,36 +7,84 @@
 #include <vector>
 
 #include "errors.hpp"
+#include "num_vector.hpp"
+#include "numbers.hpp"
+#include "persistent_map.hpp"
+#include "structs.hpp"
 #include "util.hpp"
 
-static char const *otts[] = {"List", "Symbol",   "String", "Number",
-                             "Nil",  "Function", "Boolean", "HashTable"};
+static char const *otts[] = {"List",          "Symbol",   "String",
+                             "Number",        "Nil",      "Function",
+                             "Boolean",       "HashTable", "Environment",
+                             "PersistentMap", "MapNode",  "Struct",
+                             "NumVector",     "BigInt",   "Float"};
 
-Object *nil_obj;
-Object *true_obj;
-Object *false_obj;
 Object *dot_obj;
 Object *else_obj;
 
+InternTable INTERNED;
+
+SymbolId intern(std::string_view name) {
+  auto it = INTERNED.ids.find(name);
+  if (it != INTERNED.ids.end()) return it->second;
+  SymbolId id = INTERNED.names.size();
+  auto *stored = new std::string(name);
+  INTERNED.names.push_back(stored);
+  INTERNED.ids[*stored] = id;
+  auto *sym = create_sym_obj(id);
+  gc_pin(sym);
+  INTERNED.symbols.push_back(sym);
+  return id;
+}
+
 char const *obj_type_to_str(ObjType ot) { return otts[(int)ot]; }
 
-char const *obj_type_s(Object *a) { return obj_type_to_str(a->type); }
+char const *obj_type_s(Object *a) { return obj_type_to_str(obj_type(a)); }
+
+// (name '((key value)...)) for the tables and maps, for_each_entry calls
+// its argument with every key and value
+template <typename F>
+std::string *entries_to_string(char const *name, F for_each_entry) {
+  auto *res = new std::string(format("({} '(", name));
+  bool need_space = false;
+  for_each_entry([&](Object *key_obj, Object *val) {
+    auto *key_s = obj_to_string_bare(key_obj);
+    auto *val_s = obj_to_string_bare(val);
+    if (need_space) {
+      *res += " ";
+    }
+    *res += "(";
+    *res += *key_s;
+    *res += " ";
+    *res += *val_s;
+    *res += ")";
+    delete key_s;
+    delete val_s;
+    need_space = true;
+  });
+  *res += "))";
+  return res;
+}
 
 std::string *obj_to_string_bare(Object *obj) {
-  switch (obj->type) {
+  switch (obj_type(obj)) {
     case ObjType::String: {
       return new std::string(*obj->val.s_value);
     } break;
     case ObjType::Symbol: {
       auto *res = new std::string("[Symbol \"");
-      *res += *obj->val.s_value;
+      *res += sym_name(obj);
       *res += "\"]";
       return res;
     } break;
     case ObjType::Number: {
-      auto *s = new std::string(std::to_string(obj->val.i_value));
+      auto *s = new std::string(std::to_string(num_value(obj)));
       return s;
     } break;
+    case ObjType::BigInt:
+    case ObjType::Float: {
+      return number_to_string(obj);
+    } break;
     case ObjType::Function: {
       auto const *fn = fun_name(obj);
       std::string *s = new std::string("[Function ");
@@ -68,26 +116,19 @@ std::string *obj_to_string_bare(Object *obj) {
       return nullptr;
     } break;
     case ObjType::HashTable: {
-      auto *res = new std::string("(hash-table '(");
-      bool need_space = false;
-      for (auto &item : *obj->val.ht_value) {
-        auto [key_obj, val] = item.second;
-        auto *key_s = obj_to_string_bare(key_obj);
-        auto *val_s = obj_to_string_bare(val);
-        if (need_space) {
-          *res += " ";
-        }
-        *res += "(";
-        *res += *key_s;
-        *res += " ";
-        *res += *val_s;
-        *res += ")";
-        delete key_s;
-        delete val_s;
-        need_space = true;
-      }
-      *res += "))";
-      return res;
+      return entries_to_string("hash-table", [&](auto f) {
+        ht_for_each(*obj->val.ht_value, f);
+      });
+    } break;
+    case ObjType::PersistentMap: {
+      return entries_to_string("persistent-map",
+                               [&](auto f) { pmap_for_each(obj, f); });
+    } break;
+    case ObjType::Struct: {
+      return struct_to_string(obj);
+    } break;
+    case ObjType::NumVector: {
+      return num_vector_to_string(obj);
     } break;
     default: {
       return new std::string("nil");
@@ -96,16 +137,20 @@ std::string *obj_to_string_bare(Object *obj) {
 }
 
 Object *sub_two_objects(Object *a, Object *b) {
-  switch (a->type) {
-    case ObjType::Number: {
-      if (b->type != ObjType::Number) {
+  if (is_fixnum(a) && is_fixnum(b)) {
+    return create_int_obj(num_value(a) - num_value(b));
+  }
+  switch (obj_type(a)) {
+    case ObjType::Number:
+    case ObjType::BigInt:
+    case ObjType::Float: {
+      if (!is_number(b)) {
         error_msg(format(
             "Can only substract numbers from other numbers, got {} and {}",
             obj_type_s(a), obj_type_s(b)));
         return nil_obj;
       }
-      auto v = a->val.i_value - b->val.i_value;
-      return create_num_obj(v);
+      return num_sub(a, b);
     } break;
     default: {
       error_binop_not_defined("Substraction", a, b);
@@ -116,19 +161,23 @@ Object *sub_two_objects(Object *a, Object *b) {
 
 Object *add_two_objects(Object *a, Object *b) {
   static char const *opname = "Addition";
-  switch (a->type) {
-    case ObjType::Number: {
-      if (b->type != ObjType::Number) {
+  if (is_fixnum(a) && is_fixnum(b)) {
+    return create_int_obj(num_value(a) + num_value(b));
+  }
+  switch (obj_type(a)) {
+    case ObjType::Number:
+    case ObjType::BigInt:
+    case ObjType::Float: {
+      if (!is_number(b)) {
         error_msg(
             format("Can only add numbers from other numbers, got {} and {}",
                    obj_type_s(a), obj_type_s(b)));
         return nil_obj;
       }
-      auto v = a->val.i_value + b->val.i_value;
-      return create_num_obj(v);
+      return num_add(a, b);
     } break;
     case ObjType::String: {
-      if (b->type != ObjType::String) {
+      if (obj_type(b) != ObjType::String) {
         error_binop_not_defined(opname, a, b);
         return nil_obj;
       }
@@ -143,24 +192,29 @@ Object *add_two_objects(Object *a, Object *b) {
 }
 
 bool objects_equal_bare(Object *a, Object *b) {
+  // Numbers compare by value whatever their types
+  if (is_number(a) && is_number(b)) return num_compare(a, b) == 0;
   // Objects of different types cannot be equal
-  if (a->type != b->type) return false;
+  if (obj_type(a) != obj_type(b)) return false;
   if (a == b) return true;
-  switch (a->type) {
-    case ObjType::Number: {
-      return a->val.i_value == b->val.i_value;
-    } break;
+  switch (obj_type(a)) {
     case ObjType::String: {
+      if ((a->flags & b->flags & OF_HASHED) && a->val.s_hash != b->val.s_hash) {
+        return false;
+      }
       return *a->val.s_value == *b->val.s_value;
     } break;
     case ObjType::Boolean: {
-      return a->val.i_value == b->val.i_value;
+      return a == b;
+    } break;
+    case ObjType::Symbol: {
+      return sym_id(a) == sym_id(b);
     } break;
     case ObjType::List: {
-      if (a->val.l_value->size() != b->val.l_value->size()) return false;
-      for (size_t i = 0; i < a->val.l_value->size(); ++i) {
-        auto *a_member = a->val.l_value->at(i);
-        auto *b_member = b->val.l_value->at(i);
+      if (list_length(a) != list_length(b)) return false;
+      for (size_t i = 0; i < list_length(a); ++i) {
+        auto *a_member = list_index(a, i);
+        auto *b_member = list_index(b, i);
         if (!objects_equal_bare(a_member, b_member)) return false;
       }
       return true;
@@ -170,7 +224,13 @@ bool objects_equal_bare(Object *a, Object *b) {
     } break;
     case ObjType::Function: {
       // Comparing by argument list memory address for now. Maybe do something
-      // else later
+      // else later. Memoized functions are only equal to themselves, each
+      // one has its own cache, and so are the functions of structs
+      if ((a->flags | b->flags) & (OF_MEMOIZED | OF_STRUCT_OP)) return false;
+      if (a->flags & OF_COMPILED) {
+        return (b->flags & OF_COMPILED) &&
+               a->val.cf_value.proto == b->val.cf_value.proto;
+      }
       return a->val.f_value.funargs == b->val.f_value.funargs;
     } break;
     default:
@@ -178,19 +238,31 @@ bool objects_equal_bare(Object *a, Object *b) {
   }
 }
 
+bool keys_equal_bare(Object *a, Object *b) {
+  if (obj_type(a) != obj_type(b)) return false;
+  if (a == b) return true;
+  if (is_number(a)) return num_compare(a, b) == 0;
+  if (obj_type(a) == ObjType::List) {
+    if (list_length(a) != list_length(b)) return false;
+    for (size_t i = 0; i < list_length(a); ++i) {
+      if (!keys_equal_bare(list_index(a, i), list_index(b, i))) return false;
+    }
+    return true;
+  }
+  return objects_equal_bare(a, b);
+}
+
 bool objects_gt_bare(Object *a, Object *b) {
   // Objects of different types cannot be compared
   // TODO: Maybe return nil instead?
-  if (a->type != b->type) return false_obj;
-  switch (a->type) {
-    case ObjType::Number: {
-      return a->val.i_value > b->val.i_value;
-    } break;
+  if (is_number(a) && is_number(b)) return num_compare(a, b) == 1;
+  if (obj_type(a) != obj_type(b)) return false_obj;
+  switch (obj_type(a)) {
     case ObjType::String: {
       return a->val.s_value > b->val.s_value;
     } break;
     case ObjType::Boolean: {
-      return a->val.i_value > b->val.i_value;
+      return bool_value(a) > bool_value(b);
     } break;
     default:
       return false_obj;
@@ -200,16 +272,14 @@ bool objects_gt_bare(Object *a, Object *b) {
 bool objects_lt_bare(Object *a, Object *b) {
   // Objects of different types cannot be compared
   // TODO: Maybe return nil instead?
-  if (a->type != b->type) return false_obj;
-  switch (a->type) {
-    case ObjType::Number: {
-      return a->val.i_value < b->val.i_value;
-    } break;
+  if (is_number(a) && is_number(b)) return num_compare(a, b) == -1;
+  if (obj_type(a) != obj_type(b)) return false_obj;
+  switch (obj_type(a)) {
     case ObjType::String: {
       return a->val.s_value < b->val.s_value;
     } break;
     case ObjType::Boolean: {
-      return a->val.i_value < b->val.i_value;
+      return bool_value(a) < bool_value(b);
     } break;
     default:
       return false_obj;
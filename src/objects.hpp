@@ -3,20 +3,29 @@
 
 #include <fmt/core.h>
 #include <math.h>
+#include <stdint.h>
 
 #include <iostream>
 #include <optional>
+#include <span>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
 #include "errors.hpp"
+#include "gc.hpp"
+#include "hash_table.hpp"
+#include "heap.hpp"
 #include "types.hpp"
 #include "util.hpp"
 
 using fmt::format;
 
-enum class ObjType {
+// Stored in the first byte of heap objects, which the heap reserves the
+// value HEAP_FREE_CELL of
+enum class ObjType : u8 {
   List,
   Symbol,
   String,
@@ -24,75 +33,277 @@ enum class ObjType {
   Nil,
   Function,
   Boolean,
-  HashTable
+  HashTable,
+  Environment,
+  PersistentMap,
+  MapNode,
+  Struct,
+  NumVector,
+  // integers past the fixnums and doubles, see numbers.hpp
+  BigInt,
+  Float
 };
 
 const int OF_BUILTIN = 0x1;
 const int OF_LAMBDA = 0x2;
 const int OF_EVALUATED = 0x4;
 const int OF_LIST_LITERAL = 0x8;
-// if this flag is true, don't GC this object
-const int OF_PERSISTENT = 0xF;
+// pinned object, never collected (see gc_pin)
+const int OF_PERSISTENT = 0x40;
+// built-in that receives its arguments unevaluated (if, let, defun...)
+const int OF_SPECIAL = 0x10;
+// user function produced by the bytecode compiler (see compiler.hpp)
+const int OF_COMPILED = 0x20;
+// function caching the results of another one (see memo.hpp)
+const int OF_MEMOIZED = 0x80;
+// string whose hash is computed, see obj_hash_bare
+const int OF_HASHED = 0x100;
+// map node of keys with equal hashes (see persistent_map.hpp)
+const int OF_COLLISIONS = 0x200;
+// function defstruct binds (see structs.hpp)
+const int OF_STRUCT_OP = 0x400;
+
+// Element type of numeric vectors (see num_vector.hpp)
+enum class VecKind : u8 { I64, F64 };
 
 struct Object;
+struct Proto;
+struct MemoCache;
+struct StructType;
+struct StructOp;
+
+// Expected number of arguments: at most, at least or exactly n
+enum class EA {
+  LEQ,
+  GEQ,
+  EQ,
+};
+
+// Name and arity of a built-in or special form. The evaluators check the
+// calls to built-ins against it, once per call site when they can (see
+// builtin_accepts).
+struct BuiltinSpec {
+  char const *name;
+  EA arity;
+  u32 nargs;
+};
+
+inline bool builtin_accepts(BuiltinSpec const *spec, u64 nargs) {
+  switch (spec->arity) {
+    case EA::LEQ:
+      return nargs <= spec->nargs;
+    case EA::GEQ:
+      return nargs >= spec->nargs;
+    case EA::EQ:
+      return nargs == spec->nargs;
+  }
+  return false;
+}
 
-using Builtin = Object *(*)(Object *);
+// Members of a list, shared by the list and the slices of it (see
+// list_slice). Every list only uses (and the collector only traces) its own
+// range of the items.
+struct ListStore {
+  std::vector<Object *> items;
+  // lists using the store
+  u32 refs;
+};
+
+// Built-ins get their arguments already evaluated
+using Builtin = Object *(*)(Object **args, u32 nargs);
+// Special forms get the whole unevaluated expression
+using SpecialForm = Object *(*)(Object *expr);
 using BinaryObjOpHandler = Object *(*)(Object *a, Object *b);
-using ObjectHash = i64;
-using HashTableValue = std::pair<Object *, Object *>;
-using HashTable = std::unordered_map<ObjectHash, HashTableValue>;
+
+// Values are Object pointers, but not all of them point to the heap: objects
+// are 8-byte aligned and the low bits of the pointer tag immediate values.
+//   ...xx1  fixnum, the number is in the upper 63 bits
+//   ...010  nil, false and true (see IMM_* below)
+//   ...000  heap object
+// Use obj_type, obj_flags and num_value rather than the Object fields unless
+// the value is known to be on the heap.
+const uintptr_t FIXNUM_TAG = 0x1;
+const uintptr_t IMM_TAG = 0x2;
+const uintptr_t TAG_MASK = 0x7;
+const uintptr_t IMM_NIL = IMM_TAG;
+const uintptr_t IMM_FALSE = IMM_TAG | 0x8;
+const uintptr_t IMM_TRUE = IMM_TAG | 0x10;
+// Integers in this range are fixnums, the others are BigInt objects
+const i64 FIXNUM_MAX = ((i64)1 << 62) - 1;
+const i64 FIXNUM_MIN = -((i64)1 << 62);
 
 struct Object {
   ObjType type;
-  int flags = 0;
-  // how many references are there in the system to this object
-  u32 ref = 0;
+  // GC_* bits of the collector
+  u8 gc_bits;
+  u16 flags;
+  // index + 1 of the CallSite the tree-walker keeps for the lists it
+  // evaluates as calls, 0 if none
+  u32 call_site;
   union {
-    int i_value;
-    std::string *s_value;
-    std::vector<Object *> *l_value;
     struct {
-      char const *name;
-      Builtin builtin_handler;
+      std::string *s_value;
+      // valid with OF_HASHED, strings never change once created
+      ObjectHash s_hash;
+    };
+    struct {
+      std::string const *name;
+      SymbolId id;
+    } sym_value;
+    struct {
+      ListStore *store;
+      u32 from;
+      u32 size;
+    } l_value;
+    struct {
+      BuiltinSpec const *spec;
+      union {
+        Builtin builtin_handler;
+        SpecialForm special_handler;
+      };
     } bf_value;
     struct {
       Object *funargs;
       Object *funbody;
     } f_value;
+    struct {
+      Proto *proto;
+      // environment the function was created in
+      Object *env;
+    } cf_value;
+    struct {
+      Object *fun;
+      MemoCache *cache;
+    } memo_value;
+    // Local variables of a function activation that are visible to the
+    // functions defined inside of it
+    struct {
+      Object *parent;
+      std::vector<Object *> *slots;
+    } env_value;
     HashTable *ht_value;
+    struct {
+      // nullptr for the empty map
+      Object *root;
+      u64 count;
+    } pmap_value;
+    struct {
+      // the pairs (key, value), then the child nodes
+      Object **items;
+      u32 datamap;
+      u32 nodemap;
+    } node_value;
+    struct {
+      StructType const *type;
+      // one per field of the type
+      Object **slots;
+    } struct_value;
+    StructOp const *sop_value;
+    struct {
+      union {
+        i64 *i64s;
+        double *f64s;
+      };
+      u32 size;
+      VecKind kind;
+    } vec_value;
+    struct {
+      // the magnitude, see bignum.hpp, never fits in a fixnum
+      std::vector<u32> *limbs;
+      bool negative;
+    } big_value;
+    double d_value;
   } val;
 };
 
-extern Object *nil_obj;
-extern Object *true_obj;
-extern Object *false_obj;
+inline Object *const nil_obj = (Object *)IMM_NIL;
+inline Object *const true_obj = (Object *)IMM_TRUE;
+inline Object *const false_obj = (Object *)IMM_FALSE;
 extern Object *dot_obj;
 extern Object *else_obj;
 
 char const *obj_type_to_str(ObjType ot);
 std::string *obj_to_string_bare(Object *);
+void release_call_site(u32 call_site);
+void delete_memo_cache(MemoCache *cache);
+void retain_proto(Proto *proto);
+void release_proto(Proto *proto);
+char const *struct_op_name(StructOp const *op);
+ObjectHash number_hash(Object *num);
 
-inline void inc_ref(Object *o) { ++o->ref; }
+inline bool is_heap_obj(Object const *o) {
+  return ((uintptr_t)o & TAG_MASK) == 0;
+}
 
-inline void delete_obj(Object *o) {
+inline bool is_fixnum(Object const *o) { return (uintptr_t)o & FIXNUM_TAG; }
+
+inline ObjType obj_type(Object const *o) {
+  if (is_heap_obj(o)) return o->type;
+  if (is_fixnum(o)) return ObjType::Number;
+  return o == nil_obj ? ObjType::Nil : ObjType::Boolean;
+}
+
+// immediates are constants
+inline int obj_flags(Object const *o) {
+  if (is_heap_obj(o)) return o->flags;
+  return OF_EVALUATED | OF_PERSISTENT;
+}
+
+inline i64 num_value(Object const *o) { return (intptr_t)o >> 1; }
+
+inline bool fits_fixnum(i64 v) { return v >= FIXNUM_MIN && v <= FIXNUM_MAX; }
+
+inline bool bool_value(Object const *o) { return o == true_obj; }
+
+// Frees what the object owns outside of the heap, before the collector
+// reuses its cell
+inline void finalize_obj(Object *o) {
   switch (o->type) {
     case ObjType::String: {
       delete o->val.s_value;
     } break;
     case ObjType::List: {
-      delete o->val.l_value;
-    } break;
-    case ObjType::Number: {
+      if (--o->val.l_value.store->refs == 0) delete o->val.l_value.store;
+      if (o->call_site != 0) release_call_site(o->call_site);
     } break;
     case ObjType::HashTable: {
       delete o->val.ht_value;
     } break;
+    case ObjType::MapNode: {
+      delete[] o->val.node_value.items;
+    } break;
+    case ObjType::PersistentMap: {
+      // the nodes are objects of their own, shared with the other versions
+    } break;
+    case ObjType::Struct: {
+      delete[] o->val.struct_value.slots;
+    } break;
+    case ObjType::NumVector: {
+      heap_external_free(o->val.vec_value.size * sizeof(i64));
+      if (o->val.vec_value.kind == VecKind::I64) {
+        delete[] o->val.vec_value.i64s;
+      } else {
+        delete[] o->val.vec_value.f64s;
+      }
+    } break;
+    case ObjType::BigInt: {
+      heap_external_free(o->val.big_value.limbs->size() * sizeof(u32));
+      delete o->val.big_value.limbs;
+    } break;
+    case ObjType::Environment: {
+      delete o->val.env_value.slots;
+    } break;
     case ObjType::Function: {
-      delete_obj(o->val.f_value.funargs);
-      delete_obj(o->val.f_value.funbody);
+      // the parts of functions are objects of their own or shared with the
+      // prototype, except for the result caches and the compiled code
+      if (o->flags & OF_MEMOIZED) delete_memo_cache(o->val.memo_value.cache);
+      if (o->flags & OF_COMPILED) release_proto(o->val.cf_value.proto);
     } break;
     case ObjType::Symbol: {
-      delete o->val.s_value;
+      // symbol names are owned by the intern table
+    } break;
+    case ObjType::Float: {
+      // the double is stored in the object
     } break;
     default: {
       assert_stmt(
@@ -100,44 +311,60 @@ inline void delete_obj(Object *o) {
           format(
               "Impossible case: trying to delete unknown object of type \"{}\"",
               obj_type_to_str(o->type)));
-      return;
     } break;
   }
-  delete o;
 }
 
-inline void dec_ref(Object *o) {
-  if (o->ref != 0) {
-    --o->ref;
-  } else {
-    // delete_obj(o);
+// Called before a reference to value is stored in holder (see gc.hpp)
+inline void gc_write_barrier(Object *holder, Object *value) {
+  if (!is_heap_obj(value)) return;
+  u8 holder_bits = holder->gc_bits;
+  u8 value_bits = value->gc_bits;
+  if (GC.phase == GCPhase::Marking) {
+    // no black object may refer to a white one, every survivor becomes old
+    if ((holder_bits & GC_MARK) && !(value_bits & GC_MARK)) gc_shade(value);
+    return;
+  }
+  // Young objects stored in old ones are remembered for the minor
+  // collections. While sweeping, the marked objects are about to become old.
+  if (GC.generational && (holder_bits & (GC_OLD | GC_MARK)) &&
+      !(value_bits & (GC_OLD | GC_MARK | GC_REMEMBERED))) {
+    value->gc_bits |= GC_REMEMBERED;
+    GC.remembered.push_back(value);
+  }
+}
+
+// Called before value becomes a constant of compiled code, which is
+// traced in major collections only (see gc_mark_proto): the code is taken
+// as an old, marked holder
+inline void gc_const_barrier(Object *value) {
+  if (!is_heap_obj(value)) return;
+  if (GC.phase == GCPhase::Marking) {
+    if (!(value->gc_bits & GC_MARK)) gc_shade(value);
+    return;
+  }
+  if (GC.generational &&
+      !(value->gc_bits & (GC_OLD | GC_MARK | GC_REMEMBERED))) {
+    value->gc_bits |= GC_REMEMBERED;
+    GC.remembered.push_back(value);
   }
 }
 
 inline Object *new_object(ObjType type, int flags = 0) {
-  Object *res = (Object *)malloc(sizeof(*res));
+  Object *res = (Object *)heap_alloc(sizeof(*res));
   res->type = type;
+  res->gc_bits = GC.alloc_bits;
   res->flags = flags;
-  IS.objects_pool.push_back(res);
+  res->call_site = 0;
   return res;
 }
 
-inline Object *create_nil_obj() {
-  return new_object(ObjType::Nil, OF_EVALUATED | OF_PERSISTENT);
-}
-
 inline Object *create_str_obj(std::string *s) {
   auto *res = new_object(ObjType::String, OF_EVALUATED);
   res->val.s_value = s;
   return res;
 }
 
-inline Object *create_bool_obj(bool v) {
-  auto *res = new_object(ObjType::Boolean, OF_EVALUATED | OF_PERSISTENT);
-  res->val.i_value = (int)v;
-  return res;
-}
-
 inline Object *bool_obj_from(bool v) {
   if (v) return true_obj;
   return false_obj;
@@ -160,27 +387,93 @@ inline Object *create_hash_table_obj() {
   return res;
 }
 
-inline std::optional<ObjectHash> obj_hash(Object *obj) {
-  switch (obj->type) {
+inline Object *create_list_obj() {
+  auto *res = new_object(ObjType::List);
+  res->val.l_value.store = new ListStore{{}, 1};
+  res->val.l_value.from = 0;
+  res->val.l_value.size = 0;
+  return res;
+}
+
+inline Object *create_data_list_obj() {
+  auto *res = create_list_obj();
+  res->flags |= OF_EVALUATED;
+  return res;
+}
+
+inline size_t list_length(Object const *list) {
+  return list->val.l_value.size;
+}
+
+inline Object *list_index(Object *list, size_t i) {
+  auto &l = list->val.l_value;
+  if (i >= l.size) throw std::out_of_range("list_index");
+  return l.store->items[l.from + i];
+}
+
+inline std::span<Object *> list_members(Object *list) {
+  auto &l = list->val.l_value;
+  return std::span<Object *>(l.store->items.data() + l.from, l.size);
+}
+
+inline u64 hash_combine(u64 seed, u64 hash) {
+  return seed ^ (hash + 0x9e3779b97f4a7c15 + (seed << 6) + (seed >> 2));
+}
+
+// Structural hash of keys, the same for the objects keys_equal_bare takes
+// as equal. Empty for the objects that can't be hashed (functions, tables).
+inline std::optional<ObjectHash> obj_hash_bare(Object *obj) {
+  switch (obj_type(obj)) {
     case ObjType::Number: {
-      return std::hash<int>{}(obj->val.i_value);
+      return std::hash<i64>{}(num_value(obj));
+    } break;
+    case ObjType::BigInt:
+    case ObjType::Float: {
+      return number_hash(obj);
     } break;
     case ObjType::String: {
-      return std::hash<std::string>{}(*obj->val.s_value);
+      if (!(obj->flags & OF_HASHED)) {
+        obj->val.s_hash = std::hash<std::string>{}(*obj->val.s_value);
+        obj->flags |= OF_HASHED;
+      }
+      return obj->val.s_hash;
+    } break;
+    case ObjType::Symbol: {
+      // by identity, the interned symbols are the same for the same name
+      return hash_combine((u64)ObjType::Symbol, obj->val.sym_value.id);
+    } break;
+    case ObjType::Nil:
+    case ObjType::Boolean: {
+      return (ObjectHash)(uintptr_t)obj;
+    } break;
+    case ObjType::List: {
+      u64 res = (u64)ObjType::List;
+      for (auto *member : list_members(obj)) {
+        auto hash = obj_hash_bare(member);
+        if (!hash) return {};
+        res = hash_combine(res, *hash);
+      }
+      return res;
     } break;
     default: {
-      error_msg(format("Object of type {} is not hashable",
-                       obj_type_to_str(obj->type)));
       return {};
     } break;
   }
 }
 
+inline std::optional<ObjectHash> obj_hash(Object *obj) {
+  auto res = obj_hash_bare(obj);
+  if (!res) {
+    error_msg(format("Object of type {} is not hashable",
+                     obj_type_to_str(obj_type(obj))));
+  }
+  return res;
+}
+
 inline Object *hash_table_get(Object *ht, Object *key_obj) {
   if (auto hash = obj_hash(key_obj)) {
-    auto res = ht->val.ht_value->find(*hash);
-    if (res == ht->val.ht_value->end()) return nil_obj;
-    return std::get<1>(res->second);
+    auto *res = ht_find(*ht->val.ht_value, *hash, key_obj);
+    return res != nullptr ? res : nil_obj;
   } else {
     return nil_obj;
   }
@@ -188,102 +481,161 @@ inline Object *hash_table_get(Object *ht, Object *key_obj) {
 
 inline void hash_table_set(Object *ht, Object *key, Object *val) {
   if (auto hash = obj_hash(key)) {
-    inc_ref(key);
-    inc_ref(val);
-    (*ht->val.ht_value)[*hash] = std::make_pair(key, val);
+    gc_write_barrier(ht, key);
+    gc_write_barrier(ht, val);
+    ht_set(*ht->val.ht_value, *hash, key, val);
   }
 }
 
-inline Object *create_list_obj() {
-  auto *res = new_object(ObjType::List);
-  res->val.l_value = new std::vector<Object *>();
-  return res;
-}
-
-inline Object *create_data_list_obj() {
-  auto *res = create_list_obj();
-  res->flags |= OF_EVALUATED;
+// Returns whether the key was in the table
+inline bool hash_table_remove(Object *ht, Object *key) {
+  if (auto hash = obj_hash(key)) {
+    return ht_remove(*ht->val.ht_value, *hash, key);
+  }
+  return false;
+}
+
+inline size_t hash_table_count(Object *ht) { return ht->val.ht_value->size; }
+
+inline bool is_list(Object *obj) { return obj_type(obj) == ObjType::List; }
+
+// The members of the list from from to to (exclusive, both clamped to the
+// list). They're shared with the list, so it's O(1).
+inline Object *list_slice(Object *list, size_t from, size_t to) {
+  auto &l = list->val.l_value;
+  to = std::min<size_t>(to, l.size);
+  from = std::min(from, to);
+  auto *res = new_object(ObjType::List, list->flags & OF_EVALUATED);
+  res->val.l_value.store = l.store;
+  res->val.l_value.from = l.from + from;
+  res->val.l_value.size = to - from;
+  ++l.store->refs;
+  // allocated black, but the members weren't stored through the barrier
+  if (GC.phase == GCPhase::Marking) {
+    res->gc_bits &= ~GC_MARK;
+    gc_shade(res);
+  }
   return res;
 }
 
-inline size_t list_length(Object const *list) {
-  return list->val.l_value->size();
-}
-
-inline Object *list_index(Object *list, size_t i) {
-  return list->val.l_value->at(i);
-}
-
-inline std::vector<Object *> *list_members(Object *list) {
-  return list->val.l_value;
+inline void list_append_inplace(Object *list, Object *item) {
+  gc_write_barrier(list, item);
+  auto &l = list->val.l_value;
+  auto &items = l.store->items;
+  if (l.from + l.size != items.size()) {
+    // the items after the list belong to the other lists using the store
+    if (l.store->refs == 1) {
+      items.resize(l.from + l.size);
+    } else {
+      auto *store = new ListStore();
+      store->items.assign(items.begin() + l.from,
+                          items.begin() + l.from + l.size);
+      store->refs = 1;
+      --l.store->refs;
+      l.store = store;
+      l.from = 0;
+    }
+  }
+  l.store->items.push_back(item);
+  ++l.size;
 }
 
-inline bool is_list(Object *obj) { return obj->type == ObjType::List; }
-
-inline void list_append_inplace(Object *list, Object *item) {
-  inc_ref(item);
-  list->val.l_value->push_back(item);
+// Makes room for n more members
+inline void list_reserve(Object *list, size_t n) {
+  auto &l = list->val.l_value;
+  l.store->items.reserve(l.from + l.size + n);
 }
 
 inline void list_append_list_inplace(Object *list, Object *to_append) {
-  if (to_append->type != ObjType::List) {
+  if (obj_type(to_append) != ObjType::List) {
     list_append_inplace(list, to_append);
     return;
   }
-  for (auto *item : *list_members(to_append)) {
+  for (auto *item : list_members(to_append)) {
     list_append_inplace(list, item);
   }
 }
 
+char const *proto_name(Proto const *proto);
+
 inline char const *fun_name(Object *fun) {
-  assert_stmt(fun->type == ObjType::Function,
+  assert_stmt(obj_type(fun) == ObjType::Function,
               "fun_name only accepts functions");
   if (fun->flags & OF_BUILTIN) {
-    return fun->val.bf_value.name;
+    return fun->val.bf_value.spec->name;
+  }
+  if (fun->flags & OF_COMPILED) {
+    return proto_name(fun->val.cf_value.proto);
   }
-  return list_index(fun->val.f_value.funargs, 0)->val.s_value->data();
+  if (fun->flags & OF_MEMOIZED) return fun_name(fun->val.memo_value.fun);
+  if (fun->flags & OF_STRUCT_OP) return struct_op_name(fun->val.sop_value);
+  return list_index(fun->val.f_value.funargs, 0)->val.sym_value.name->data();
 }
 
-inline Object *create_sym_obj(char const *s) {
-  auto *res = new_object(ObjType::Symbol);
-  res->val.s_value = new std::string(s);
-  return res;
+////////////////////////////////////////
+// Symbols
+////////////////////////////////////////
+
+// Every distinct symbol name is stored once and gets a dense id. The reader
+// shares a single symbol object per name.
+struct InternTable {
+  std::unordered_map<std::string_view, SymbolId> ids;
+  std::vector<std::string *> names;
+  std::vector<Object *> symbols;
+};
+
+extern InternTable INTERNED;
+
+SymbolId intern(std::string_view name);
+
+inline std::string const &symbol_name(SymbolId id) {
+  return *INTERNED.names[id];
 }
 
-inline Object *create_sym_obj(std::string *s) {
+inline SymbolId sym_id(Object const *sym) { return sym->val.sym_value.id; }
+
+inline std::string const &sym_name(Object const *sym) {
+  return *sym->val.sym_value.name;
+}
+
+inline Object *create_sym_obj(SymbolId id) {
   auto *res = new_object(ObjType::Symbol);
-  res->val.s_value = s;
+  res->val.sym_value.name = INTERNED.names[id];
+  res->val.sym_value.id = id;
   return res;
 }
 
+// Returns the shared symbol object for the name
+inline Object *intern_sym_obj(std::string_view name) {
+  return INTERNED.symbols[intern(name)];
+}
+
 // this is for symbol keywords that don't need to be looked up
-template <typename T>
-inline Object *create_final_sym_obj(T s) {
-  auto *res = create_sym_obj(s);
+inline Object *create_final_sym_obj(char const *s) {
+  auto *res = create_sym_obj(intern(s));
   res->flags |= OF_EVALUATED;
-  res->flags |= OF_PERSISTENT;
+  gc_pin(res);
   return res;
 }
 
-inline Object *create_num_obj(int v) {
-  auto *res = new_object(ObjType::Number, OF_EVALUATED);
-  res->val.i_value = v;
-  return res;
+// v must fit in a fixnum, see create_int_obj for any integer
+inline Object *create_num_obj(i64 v) {
+  return (Object *)(((uintptr_t)(intptr_t)v << 1) | FIXNUM_TAG);
 }
 
 inline bool is_truthy(Object *obj) {
-  switch (obj->type) {
+  switch (obj_type(obj)) {
     case ObjType::Boolean: {
-      return obj->val.i_value != 0;
+      return bool_value(obj);
     } break;
     case ObjType::Number: {
-      return obj->val.i_value != 0;
+      return num_value(obj) != 0;
     } break;
     case ObjType::String: {
       return obj->val.s_value->size() != 0;
     } break;
     case ObjType::List: {
-      return obj->val.l_value->size() != 0;
+      return list_length(obj) != 0;
     } break;
     case ObjType::Nil: {
       return false;
@@ -291,6 +643,21 @@ inline bool is_truthy(Object *obj) {
     case ObjType::Function: {
       return true;
     } break;
+    case ObjType::PersistentMap: {
+      return obj->val.pmap_value.count != 0;
+    } break;
+    case ObjType::Struct: {
+      return true;
+    } break;
+    case ObjType::NumVector: {
+      return obj->val.vec_value.size != 0;
+    } break;
+    case ObjType::BigInt: {
+      return true;
+    } break;
+    case ObjType::Float: {
+      return obj->val.d_value != 0;
+    } break;
     default: {
       return false;
     } break;
@@ -303,7 +670,7 @@ std::string *obj_to_string_bare(Object *obj);
 
 inline Object *obj_to_string(Object *obj) {
   // TODO: Implement for symbols
-  switch (obj->type) {
+  switch (obj_type(obj)) {
     case ObjType::String: {
       return obj;
     } break;
@@ -314,41 +681,87 @@ inline Object *obj_to_string(Object *obj) {
   }
 }
 
-inline Object *create_builtin_fobj(char const *name, Builtin handler) {
-  Object *res = new_object(ObjType::Function, OF_BUILTIN | OF_EVALUATED | OF_PERSISTENT);
+inline Object *create_builtin_fobj(BuiltinSpec const *spec,
+                                   Builtin handler) {
+  Object *res = new_object(ObjType::Function, OF_BUILTIN | OF_EVALUATED);
   res->val.bf_value.builtin_handler = handler;
-  res->val.bf_value.name = name;
+  res->val.bf_value.spec = spec;
+  gc_pin(res);
+  return res;
+}
+
+inline Object *create_special_fobj(BuiltinSpec const *spec,
+                                   SpecialForm handler) {
+  Object *res = create_builtin_fobj(spec, nullptr);
+  res->flags |= OF_SPECIAL;
+  res->val.bf_value.special_handler = handler;
+  return res;
+}
+
+inline Object *create_compiled_fobj(Proto *proto, Object *env,
+                                   bool is_lambda) {
+  Object *res = new_object(ObjType::Function, OF_COMPILED | OF_EVALUATED);
+  if (is_lambda) res->flags |= OF_LAMBDA;
+  retain_proto(proto);
+  // the new function is black while marking, its code mustn't refer to
+  // white objects
+  if (GC.phase == GCPhase::Marking) gc_mark_proto(proto);
+  res->val.cf_value.proto = proto;
+  if (env != nullptr) gc_write_barrier(res, env);
+  res->val.cf_value.env = env;
+  return res;
+}
+
+inline Object *create_env_obj(Object *parent, Object **slots, u32 nslots) {
+  auto *res = new_object(ObjType::Environment, OF_EVALUATED);
+  if (parent != nullptr) gc_write_barrier(res, parent);
+  for (u32 i = 0; i < nslots; ++i) gc_write_barrier(res, slots[i]);
+  res->val.env_value.parent = parent;
+  res->val.env_value.slots = new std::vector<Object *>(slots, slots + nslots);
   return res;
 }
 
+inline Object *env_slot(Object *env, u32 depth, u32 slot) {
+  while (depth-- > 0) env = env->val.env_value.parent;
+  return (*env->val.env_value.slots)[slot];
+}
+
+inline void env_set_slot(Object *env, u32 depth, u32 slot, Object *value) {
+  while (depth-- > 0) env = env->val.env_value.parent;
+  gc_write_barrier(env, value);
+  (*env->val.env_value.slots)[slot] = value;
+}
+
 inline void print_obj(Object *obj, int indent = 0) {
   char indent_s[16];
   memset(indent_s, ' ', indent);
   indent_s[indent] = '\0';
-  switch (obj->type) {
+  switch (obj_type(obj)) {
     case ObjType::Number: {
-      printf("%s[Num] %i", indent_s, obj->val.i_value);
+      printf("%s[Num] %lld", indent_s, (long long)num_value(obj));
     } break;
     case ObjType::String: {
       printf("%s[Str] %s", indent_s, obj->val.s_value->data());
     } break;
     case ObjType::Symbol: {
-      printf("%s[Sym] %s", indent_s, obj->val.s_value->data());
+      printf("%s[Sym] %s", indent_s, sym_name(obj).data());
     } break;
     case ObjType::Function: {
       if (obj->flags & OF_BUILTIN) {
-        auto *funname = obj->val.bf_value.name;
+        auto *funname = obj->val.bf_value.spec->name;
         printf("%s[Builtin] %s\n", indent_s, funname);
+      } else if (obj->flags & (OF_COMPILED | OF_MEMOIZED | OF_STRUCT_OP)) {
+        printf("%s[Function] %s\n", indent_s, fun_name(obj));
       } else {
         auto fval = obj->val.f_value;
-        auto *funname = fval.funargs->val.l_value->at(0)->val.s_value;
+        auto *funname = list_index(fval.funargs, 0)->val.sym_value.name;
         printf("%s[Function] %s\n", indent_s, funname->data());
       }
     } break;
     case ObjType::List: {
-      printf("%s[List] %lu: \n", indent_s, obj->val.l_value->size());
-      for (size_t i = 0; i < obj->val.l_value->size(); ++i) {
-        auto *lobj = obj->val.l_value->at(i);
+      printf("%s[List] %lu: \n", indent_s, list_length(obj));
+      for (size_t i = 0; i < list_length(obj); ++i) {
+        auto *lobj = list_index(obj, i);
         print_obj(lobj, indent + 1);
         printf("\n");
       }
@@ -357,7 +770,7 @@ inline void print_obj(Object *obj, int indent = 0) {
       printf("%s[Nil]", indent_s);
     } break;
     default: {
-      printf("Unknown object of type %s\n", obj_type_to_str(obj->type));
+      printf("Unknown object of type %s\n", obj_type_to_str(obj_type(obj)));
     } break;
   }
 }
@@ -369,7 +782,7 @@ inline void print_obj(Object *obj, int indent = 0) {
 inline void error_binop_not_defined(char const *opname, Object const *a,
                                     Object const *b) {
   printf("Error: %s operation for objects of type %s and %s is not defined\n",
-         opname, obj_type_to_str(a->type), obj_type_to_str(b->type));
+         opname, obj_type_to_str(obj_type(a)), obj_type_to_str(obj_type(b)));
 }
 
 Object *sub_two_objects(Object *a, Object *b);
@@ -377,6 +790,9 @@ Object *sub_two_objects(Object *a, Object *b);
 Object *add_two_objects(Object *a, Object *b);
 
 bool objects_equal_bare(Object *a, Object *b);
+// Equality of hash table, persistent map and memo keys. Unlike =, numbers of
+// different types are different keys: 1 and 1.0 are two entries.
+bool keys_equal_bare(Object *a, Object *b);
 
 inline Object *objects_equal(Object *a, Object *b) {
   return bool_obj_from(objects_equal_bare(a, b));
@@ -394,56 +810,4 @@ inline Object *objects_lt(Object *a, Object *b) {
   return bool_obj_from(objects_lt_bare(a, b));
 }
 
-inline Object *objects_div(Object *a, Object *b) {
-  switch (a->type) {
-    case ObjType::Number: {
-      auto val = a->val.i_value / b->val.i_value;
-      return create_num_obj(val);
-    } break;
-    default: {
-      error_binop_not_defined("Division", a, b);
-      return nil_obj;
-    } break;
-  }
-}
-
-inline Object *objects_pow(Object *a, Object *b) {
-  switch (a->type) {
-    case ObjType::Number: {
-      auto val = pow(a->val.i_value, b->val.i_value);
-      return create_num_obj(val);
-    } break;
-    default: {
-      error_binop_not_defined("Power", a, b);
-      return nil_obj;
-    } break;
-  }
-}
-
-inline Object *objects_mul(Object *a, Object *b) {
-  switch (a->type) {
-    case ObjType::Number: {
-      auto val = a->val.i_value * b->val.i_value;
-      return create_num_obj(val);
-    } break;
-    default: {
-      error_binop_not_defined("Multiplication", a, b);
-      return nil_obj;
-    } break;
-  }
-}
-
-inline Object *objects_rem(Object *a, Object *b) {
-  switch (a->type) {
-    case ObjType::Number: {
-      i32 val = a->val.i_value % b->val.i_value;
-      return create_num_obj(val);
-    } break;
-    default: {
-      error_binop_not_defined("Remainder", a, b);
-      return nil_obj;
-    } break;
-  }
-}
-
 #endif
@@ -0,0 +1,278 @@
+#include "optimizer.hpp"
+
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "compiler.hpp"
+#include "interpreter.hpp"
+#include "numbers.hpp"
+#include "objects.hpp"
+
+// Global values set up by the interpreter, by symbol
+std::unordered_map<SymbolId, Object *> initial_globals;
+// Names bound by the forms seen so far
+std::unordered_set<SymbolId> bound_names;
+// Names bound by the forms seen so far to something else than a function
+// with a fixed number of arguments, see takes_evaluated_args
+std::unordered_set<SymbolId> maybe_variadic;
+// Bumped whenever a name stops being folded
+u64 generation = 0;
+
+void init_optimizer() { initial_globals = IS.globals->map; }
+
+u64 fold_generation() { return generation; }
+
+// The value the interpreter bound the symbol to, if nothing rebinds it
+Object *initial_value(Object *sym) {
+  auto id = sym_id(sym);
+  auto it = initial_globals.find(id);
+  if (it == initial_globals.end() || bound_names.contains(id)) return nullptr;
+  if (get_global(id) != it->second) {
+    initial_globals.erase(it);
+    ++generation;
+    return nullptr;
+  }
+  return it->second;
+}
+
+inline bool is_constant(Object *obj) {
+  switch (obj_type(obj)) {
+    case ObjType::Number:
+    case ObjType::BigInt:
+    case ObjType::Float:
+    case ObjType::String:
+    case ObjType::Nil:
+    case ObjType::Boolean:
+      return true;
+    default:
+      return false;
+  }
+}
+
+inline bool is_named(Object *obj, char const *name) {
+  return obj_type(obj) == ObjType::Symbol && sym_name(obj) == name;
+}
+
+// Collects the names the form binds, anywhere in it
+void collect_bound_names(Object *expr) {
+  if (obj_type(expr) != ObjType::List) return;
+  auto l = list_members(expr);
+  auto bind = [](Object *name, bool fixed_arity_function = false) {
+    if (obj_type(name) != ObjType::Symbol) return;
+    auto id = sym_id(name);
+    bool changed = initial_globals.contains(id) && !bound_names.contains(id);
+    bound_names.insert(id);
+    if (!fixed_arity_function) {
+      changed = maybe_variadic.insert(id).second || changed;
+    }
+    if (changed) ++generation;
+  };
+  if (l.size() >= 2 && is_list(l[1])) {
+    auto *head = l[0];
+    auto names = list_members(l[1]);
+    bool defun = is_named(head, "defun") || is_named(head, "defun-memo");
+    if (defun && !names.empty()) {
+      bool variadic = false;
+      for (auto *name : names) variadic = variadic || name == dot_obj;
+      bind(names[0], !variadic);
+      for (auto *name : names.subspan(1)) bind(name);
+    } else if (is_named(head, "lambda")) {
+      for (auto *name : names) bind(name);
+    } else if (is_named(head, "let")) {
+      for (auto *binding : names) {
+        if (is_list(binding) && list_length(binding) != 0) {
+          bind(list_index(binding, 0));
+        }
+      }
+    } else if (is_named(head, "dotimes") || is_named(head, "dolist")) {
+      if (!names.empty()) bind(names[0]);
+    }
+  } else if (l.size() >= 2 && is_named(l[0], "setq")) {
+    bind(l[1]);
+  }
+  for (auto *item : l) collect_bound_names(item);
+}
+
+// Result of a call to a pure built-in, nullptr if it can't be folded.
+// Anything that would report an error is left to the evaluation.
+Object *fold_call(Object *builtin, std::span<Object *> args) {
+  auto *spec = builtin->val.bf_value.spec;
+  if (!builtin_accepts(spec, args.size())) return nullptr;
+  bool numbers = true;
+  for (auto *arg : args) {
+    if (!is_constant(arg)) return nullptr;
+    numbers = numbers && is_number(arg);
+  }
+  std::string_view name = spec->name;
+  if (name == "not" || name == "null?" || name == "=") {
+    // any constants
+  } else if (name == "+") {
+    bool strings = obj_type(args[0]) == ObjType::String &&
+                   obj_type(args[1]) == ObjType::String;
+    if (!numbers && !strings) return nullptr;
+  } else if (name == "/" || name == "remainder") {
+    // integer divisions by zero
+    if (!numbers || args[1] == create_num_obj(0)) return nullptr;
+  } else if (name == "-" || name == "*" || name == "**" || name == "<" ||
+             name == ">") {
+    if (!numbers) return nullptr;
+  } else {
+    return nullptr;
+  }
+  return builtin->val.bf_value.builtin_handler(args.data(), args.size());
+}
+
+Object *fold(Object *expr);
+
+// Variadic functions get their rest arguments unevaluated, so only the
+// arguments of the functions known to take a fixed number of them are
+// folded: the ones defined so far under names no form binds otherwise
+bool takes_evaluated_args(Object *head) {
+  auto id = sym_id(head);
+  if (maybe_variadic.contains(id)) return false;
+  auto *fobj = get_global(id);
+  if (obj_type(fobj) != ObjType::Function || (obj_flags(fobj) & OF_SPECIAL)) {
+    return false;
+  }
+  if (obj_flags(fobj) & (OF_BUILTIN | OF_MEMOIZED | OF_STRUCT_OP)) return true;
+  if (obj_flags(fobj) & OF_COMPILED) {
+    return !fobj->val.cf_value.proto->variadic;
+  }
+  for (auto *arg : list_members(fobj->val.f_value.funargs)) {
+    if (arg == dot_obj) return false;
+  }
+  return true;
+}
+
+void fold_members(Object *list, size_t from) {
+  auto l = list_members(list);
+  for (size_t i = from; i < l.size(); ++i) {
+    auto *folded = fold(l[i]);
+    gc_write_barrier(list, folded);
+    l[i] = folded;
+  }
+}
+
+// Keeps the clauses of a cond that constant conditions don't rule out,
+// up to the first one that's always taken
+Object *fold_cond(Object *expr) {
+  auto l = list_members(expr);
+  for (size_t i = 1; i < l.size(); ++i) {
+    if (!is_list(l[i]) || list_length(l[i]) == 0) return expr;
+    fold_members(l[i], 0);
+  }
+  auto *res = create_list_obj();
+  list_append_inplace(res, l[0]);
+  for (size_t i = 1; i < l.size(); ++i) {
+    auto clause = list_members(l[i]);
+    auto *condition = clause[0];
+    bool always = (is_constant(condition) && is_truthy(condition)) ||
+                  (obj_type(condition) == ObjType::Symbol &&
+                   initial_value(condition) == else_obj);
+    if (always && list_length(res) == 1) {
+      // the result of the last expression of the clause, nil if none
+      if (clause.size() == 1) return nil_obj;
+      if (clause.size() == 2) return clause[1];
+    }
+    if (is_constant(condition) && !is_truthy(condition)) continue;
+    list_append_inplace(res, l[i]);
+    if (always) break;
+  }
+  return list_length(res) == 1 ? nil_obj : res;
+}
+
+Object *fold_special_form(Object *expr, char const *form) {
+  std::string_view name = form;
+  auto l = list_members(expr);
+  if (name == "if") {
+    fold_members(expr, 1);
+    if (l.size() == 4 && is_constant(l[1])) {
+      return is_truthy(l[1]) ? l[2] : l[3];
+    }
+  } else if (name == "cond") {
+    return fold_cond(expr);
+  } else if (name == "let") {
+    if (l.size() >= 2 && is_list(l[1])) {
+      for (auto *binding : list_members(l[1])) {
+        if (is_list(binding) && list_length(binding) >= 2) {
+          fold_members(binding, 1);
+        }
+      }
+    }
+    fold_members(expr, 2);
+  } else if (name == "defun" || name == "defun-memo" || name == "lambda") {
+    // The bodies run later, when the names may be bound to something else.
+    // Folding them with the current values would change what they do.
+  } else if (name == "setq") {
+    fold_members(expr, 2);
+  } else if (name == "begin" || name == "while" || name == "timeit") {
+    fold_members(expr, 1);
+  } else if (name == "dotimes" || name == "dolist") {
+    if (l.size() >= 2 && is_list(l[1]) && list_length(l[1]) == 2) {
+      fold_members(l[1], 1);
+    }
+    fold_members(expr, 2);
+  }
+  return expr;
+}
+
+Object *fold(Object *expr) {
+  if (obj_type(expr) == ObjType::Symbol) {
+    // nil, true and false, the built-ins are still looked up
+    auto *value = initial_value(expr);
+    return value != nullptr && is_constant(value) ? value : expr;
+  }
+  if (obj_type(expr) != ObjType::List || (obj_flags(expr) & OF_EVALUATED)) {
+    return expr;
+  }
+  if (obj_flags(expr) & OF_LIST_LITERAL) {
+    fold_members(expr, 0);
+    bool constant = true;
+    for (auto *item : list_members(expr)) {
+      if (!is_constant(item) && !(obj_flags(item) & OF_EVALUATED)) {
+        constant = false;
+      }
+    }
+    if (constant) expr->flags |= OF_EVALUATED;
+    return expr;
+  }
+  auto l = list_members(expr);
+  if (l.empty()) return expr;
+  auto *head = l[0];
+  if (obj_type(head) != ObjType::Symbol) {
+    auto *folded = fold(head);
+    gc_write_barrier(expr, folded);
+    l[0] = folded;
+    return expr;
+  }
+  auto *callee = initial_value(head);
+  if (callee != nullptr && obj_type(callee) == ObjType::Function) {
+    if (obj_flags(callee) & OF_SPECIAL) {
+      return fold_special_form(expr, fun_name(callee));
+    }
+    fold_members(expr, 1);
+    auto *folded = fold_call(callee, l.subspan(1));
+    return folded != nullptr ? folded : expr;
+  }
+  if (takes_evaluated_args(head)) fold_members(expr, 1);
+  return expr;
+}
+
+// Whether the form refers to eval or import anywhere, the code they run
+// may bind names before the rest of the form runs
+bool runs_other_code(Object *expr) {
+  if (is_named(expr, "eval") || is_named(expr, "import")) return true;
+  if (obj_type(expr) != ObjType::List) return false;
+  for (auto *item : list_members(expr)) {
+    if (runs_other_code(item)) return true;
+  }
+  return false;
+}
+
+Object *fold_constants(Object *expr) {
+  collect_bound_names(expr);
+  if (runs_other_code(expr)) return expr;
+  return fold(expr);
+}
@@ -0,0 +1,33 @@
+#ifndef OPTIMIZER_HPP
+#define OPTIMIZER_HPP
+
+#include "types.hpp"
+
+struct Object;
+
+// Constant folding of the forms read, before they're evaluated. Only the
+// code that runs right away is folded, not the bodies of defun and lambda:
+//   - calls to pure built-ins (arithmetic, comparisons, not, null?) on
+//     constant arguments are replaced by their result
+//   - the branches of if and cond that constant conditions rule out are
+//     pruned
+//   - nil, true and false are replaced by their values
+//   - literal lists of constants are marked evaluated, both evaluators
+//     then use them as shared constants
+// Only the names still bound to what the interpreter set up are folded: a
+// name stops being folded for good once a form binds it (with setq, defun,
+// lambda, let or a loop) or its global value changes.
+// Forms that refer to eval or import aren't folded at all, the code those
+// run may bind names the form doesn't show.
+
+// Takes the global bindings set up so far as the ones to fold
+void init_optimizer();
+
+// Folds the top-level form in place, returns the form to evaluate
+Object *fold_constants(Object *expr);
+
+// Changes whenever a name stops being folded, the forms folded before may
+// fold differently since
+u64 fold_generation();
+
+#endif
@@ -0,0 +1,294 @@
+#include "persistent_map.hpp"
+
+#include <algorithm>
+
+const u32 PMAP_MAX_SHIFT = 64;
+
+Object *create_pmap_obj(Object *root, u64 count) {
+  auto *res = new_object(ObjType::PersistentMap, OF_EVALUATED);
+  if (root != nullptr) gc_write_barrier(res, root);
+  res->val.pmap_value.root = root;
+  res->val.pmap_value.count = count;
+  return res;
+}
+
+// A node of the given size, whose items are filled by the caller before
+// publish_node
+Object *create_map_node(u32 datamap, u32 nodemap, u32 size, int flags = 0) {
+  auto *res = new_object(ObjType::MapNode, OF_EVALUATED | flags);
+  res->val.node_value.datamap = datamap;
+  res->val.node_value.nodemap = nodemap;
+  res->val.node_value.items = new Object *[size];
+  return res;
+}
+
+// Allocated black, but the items weren't stored through the barrier
+inline Object *publish_node(Object *node) {
+  if (GC.phase == GCPhase::Marking) {
+    node->gc_bits &= ~GC_MARK;
+    gc_shade(node);
+  }
+  return node;
+}
+
+// A copy of the node with the item at i replaced
+Object *node_with_item(Object *node, u32 i, Object *item) {
+  auto &n = node->val.node_value;
+  u32 size = map_node_size(node);
+  auto *res = create_map_node(n.datamap, n.nodemap, size,
+                              node->flags & OF_COLLISIONS);
+  auto *items = res->val.node_value.items;
+  std::copy(n.items, n.items + size, items);
+  items[i] = item;
+  return publish_node(res);
+}
+
+// A copy of the node with the pair inserted at item i
+Object *node_with_pair(Object *node, u32 datamap, u32 i, Object *key,
+                       Object *value) {
+  auto &n = node->val.node_value;
+  u32 size = map_node_size(node);
+  auto *res = create_map_node(datamap, n.nodemap, size + 2,
+                              node->flags & OF_COLLISIONS);
+  auto *items = res->val.node_value.items;
+  std::copy(n.items, n.items + i, items);
+  items[i] = key;
+  items[i + 1] = value;
+  std::copy(n.items + i, n.items + size, items + i + 2);
+  return publish_node(res);
+}
+
+// A copy of the node without the pair at item i
+Object *node_without_pair(Object *node, u32 datamap, u32 i) {
+  auto &n = node->val.node_value;
+  u32 size = map_node_size(node);
+  auto *res = create_map_node(datamap, n.nodemap, size - 2,
+                              node->flags & OF_COLLISIONS);
+  auto *items = res->val.node_value.items;
+  std::copy(n.items, n.items + i, items);
+  std::copy(n.items + i + 2, n.items + size, items + i);
+  return publish_node(res);
+}
+
+// A copy of the node with the pair at item i replaced by the child at item
+// j of the copy, or the other way around
+Object *node_pair_to_child(Object *node, u32 bit, u32 i, u32 j,
+                           Object *child) {
+  auto &n = node->val.node_value;
+  u32 size = map_node_size(node);
+  auto *res = create_map_node(n.datamap & ~bit, n.nodemap | bit, size - 1);
+  auto *items = res->val.node_value.items;
+  std::copy(n.items, n.items + i, items);
+  std::copy(n.items + i + 2, n.items + j + 2, items + i);
+  items[j] = child;
+  std::copy(n.items + j + 2, n.items + size, items + j + 1);
+  return publish_node(res);
+}
+
+Object *node_child_to_pair(Object *node, u32 bit, u32 i, u32 j, Object *key,
+                           Object *value) {
+  auto &n = node->val.node_value;
+  u32 size = map_node_size(node);
+  auto *res = create_map_node(n.datamap | bit, n.nodemap & ~bit, size + 1);
+  auto *items = res->val.node_value.items;
+  std::copy(n.items, n.items + i, items);
+  items[i] = key;
+  items[i + 1] = value;
+  std::copy(n.items + i, n.items + j, items + i + 2);
+  std::copy(n.items + j + 1, n.items + size, items + j + 2);
+  return publish_node(res);
+}
+
+// A node with the two pairs, in that order
+Object *pairs_node(u32 datamap, Object *key1, Object *value1, Object *key2,
+                   Object *value2, int flags = 0) {
+  auto *res = create_map_node(datamap, 0, 4, flags);
+  auto *items = res->val.node_value.items;
+  items[0] = key1;
+  items[1] = value1;
+  items[2] = key2;
+  items[3] = value2;
+  return publish_node(res);
+}
+
+inline u32 branch_bit(ObjectHash hash, u32 shift) {
+  return 1u << (((u64)hash >> shift) & (PMAP_BRANCHES - 1));
+}
+
+// Position of the branch among the ones of the bitmap
+inline u32 branch_index(u32 bitmap, u32 bit) {
+  return std::popcount(bitmap & (bit - 1));
+}
+
+inline ObjectHash key_hash(Object *key) { return *obj_hash_bare(key); }
+
+Object *node_lookup(Object *node, ObjectHash hash, Object *key) {
+  for (u32 shift = 0;; shift += PMAP_BITS) {
+    auto &n = node->val.node_value;
+    if (node->flags & OF_COLLISIONS) {
+      for (u32 i = 0; i < n.datamap; ++i) {
+        if (keys_equal_bare(n.items[2 * i], key)) {
+          return n.items[2 * i + 1];
+        }
+      }
+      return nullptr;
+    }
+    u32 bit = branch_bit(hash, shift);
+    if (n.datamap & bit) {
+      u32 i = branch_index(n.datamap, bit);
+      if (!keys_equal_bare(n.items[2 * i], key)) return nullptr;
+      return n.items[2 * i + 1];
+    }
+    if (!(n.nodemap & bit)) return nullptr;
+    u32 pairs = std::popcount(n.datamap);
+    node = n.items[2 * pairs + branch_index(n.nodemap, bit)];
+  }
+}
+
+// A node for two pairs whose keys are different, from the given level on
+Object *merge_pairs(Object *key1, Object *value1, ObjectHash hash1,
+                    Object *key2, Object *value2, ObjectHash hash2,
+                    u32 shift) {
+  if (shift >= PMAP_MAX_SHIFT) {
+    return pairs_node(2, key1, value1, key2, value2, OF_COLLISIONS);
+  }
+  u32 bit1 = branch_bit(hash1, shift);
+  u32 bit2 = branch_bit(hash2, shift);
+  if (bit1 == bit2) {
+    auto *child = merge_pairs(key1, value1, hash1, key2, value2, hash2,
+                              shift + PMAP_BITS);
+    auto *res = create_map_node(0, bit1, 1);
+    res->val.node_value.items[0] = child;
+    return publish_node(res);
+  }
+  if (bit1 < bit2) return pairs_node(bit1 | bit2, key1, value1, key2, value2);
+  return pairs_node(bit1 | bit2, key2, value2, key1, value1);
+}
+
+Object *node_assoc(Object *node, ObjectHash hash, Object *key, Object *value,
+                   u32 shift, bool &added) {
+  auto &n = node->val.node_value;
+  if (node->flags & OF_COLLISIONS) {
+    for (u32 i = 0; i < 2 * n.datamap; i += 2) {
+      if (!keys_equal_bare(n.items[i], key)) continue;
+      if (n.items[i + 1] == value) return node;
+      return node_with_item(node, i + 1, value);
+    }
+    added = true;
+    return node_with_pair(node, n.datamap + 1, 2 * n.datamap, key, value);
+  }
+  u32 bit = branch_bit(hash, shift);
+  u32 pairs = std::popcount(n.datamap);
+  if (n.datamap & bit) {
+    u32 i = 2 * branch_index(n.datamap, bit);
+    auto *other_key = n.items[i];
+    auto *other_value = n.items[i + 1];
+    if (keys_equal_bare(other_key, key)) {
+      if (other_value == value) return node;
+      return node_with_item(node, i + 1, value);
+    }
+    // the pair moves down to a child along with the new one
+    added = true;
+    auto *child = merge_pairs(other_key, other_value, key_hash(other_key), key,
+                              value, hash, shift + PMAP_BITS);
+    u32 j = 2 * (pairs - 1) + branch_index(n.nodemap, bit);
+    return node_pair_to_child(node, bit, i, j, child);
+  }
+  if (n.nodemap & bit) {
+    u32 j = 2 * pairs + branch_index(n.nodemap, bit);
+    auto *child = n.items[j];
+    auto *new_child =
+        node_assoc(child, hash, key, value, shift + PMAP_BITS, added);
+    if (new_child == child) return node;
+    return node_with_item(node, j, new_child);
+  }
+  added = true;
+  u32 i = 2 * branch_index(n.datamap, bit);
+  return node_with_pair(node, n.datamap | bit, i, key, value);
+}
+
+// Whether the node holds a single pair and no children, its parent then
+// keeps the pair instead
+inline bool single_pair(Object *node) {
+  return map_node_pairs(node) == 1 && node->val.node_value.nodemap == 0;
+}
+
+// The node without the key, nullptr if nothing is left
+Object *node_dissoc(Object *node, ObjectHash hash, Object *key, u32 shift,
+                    bool &removed) {
+  auto &n = node->val.node_value;
+  if (node->flags & OF_COLLISIONS) {
+    for (u32 i = 0; i < 2 * n.datamap; i += 2) {
+      if (!keys_equal_bare(n.items[i], key)) continue;
+      removed = true;
+      return node_without_pair(node, n.datamap - 1, i);
+    }
+    return node;
+  }
+  u32 bit = branch_bit(hash, shift);
+  u32 pairs = std::popcount(n.datamap);
+  if (n.datamap & bit) {
+    u32 i = 2 * branch_index(n.datamap, bit);
+    if (!keys_equal_bare(n.items[i], key)) return node;
+    removed = true;
+    if (map_node_size(node) == 2) return nullptr;
+    return node_without_pair(node, n.datamap & ~bit, i);
+  }
+  if (!(n.nodemap & bit)) return node;
+  u32 j = 2 * pairs + branch_index(n.nodemap, bit);
+  auto *child = n.items[j];
+  auto *new_child = node_dissoc(child, hash, key, shift + PMAP_BITS, removed);
+  if (new_child == child) return node;
+  if (!single_pair(new_child)) return node_with_item(node, j, new_child);
+  // the pair left in the child moves up to this node
+  auto *child_items = new_child->val.node_value.items;
+  u32 i = 2 * branch_index(n.datamap, bit);
+  return node_child_to_pair(node, bit, i, j, child_items[0], child_items[1]);
+}
+
+Object *pmap_lookup(Object *map, ObjectHash hash, Object *key) {
+  auto *root = map->val.pmap_value.root;
+  return root == nullptr ? nullptr : node_lookup(root, hash, key);
+}
+
+Object *pmap_assoc(Object *map, ObjectHash hash, Object *key, Object *value) {
+  auto &m = map->val.pmap_value;
+  bool added = false;
+  Object *root;
+  if (m.root == nullptr) {
+    added = true;
+    root = create_map_node(branch_bit(hash, 0), 0, 2);
+    root->val.node_value.items[0] = key;
+    root->val.node_value.items[1] = value;
+    publish_node(root);
+  } else {
+    root = node_assoc(m.root, hash, key, value, 0, added);
+  }
+  if (root == m.root) return map;
+  return create_pmap_obj(root, m.count + added);
+}
+
+Object *pmap_dissoc(Object *map, ObjectHash hash, Object *key) {
+  auto &m = map->val.pmap_value;
+  if (m.root == nullptr) return map;
+  bool removed = false;
+  auto *root = node_dissoc(m.root, hash, key, 0, removed);
+  if (!removed) return map;
+  return create_pmap_obj(root, m.count - 1);
+}
+
+Object *hash_table_to_pmap(Object *ht) {
+  auto *res = create_pmap_obj(nullptr, 0);
+  ht_for_each(*ht->val.ht_value, [&](Object *key, Object *value) {
+    res = pmap_assoc(res, key_hash(key), key, value);
+  });
+  return res;
+}
+
+Object *pmap_to_hash_table(Object *map) {
+  auto *res = create_hash_table_obj();
+  pmap_for_each(map, [&](Object *key, Object *value) {
+    hash_table_set(res, key, value);
+  });
+  return res;
+}
@@ -0,0 +1,61 @@
+#ifndef PERSISTENT_MAP_HPP
+#define PERSISTENT_MAP_HPP
+
+#include <bit>
+
+#include "objects.hpp"
+
+// Persistent maps never change: assoc and dissoc return new versions that
+// share all but the path to the changed entry with the old one. They're
+// hash array mapped tries (in the CHAMP layout) of MapNode objects, each
+// node branching on 5 bits of the hash of the keys (see obj_hash_bare). A
+// node keeps a bitmap of the branches holding an entry and one of the
+// branches holding a child node, with the pairs (key, value) first in its
+// items, then the children. Once all the bits of the hash are used, keys
+// with equal hashes share a collision node (OF_COLLISIONS) whose datamap is
+// the number of pairs.
+
+const u32 PMAP_BITS = 5;
+const u32 PMAP_BRANCHES = 1 << PMAP_BITS;
+
+Object *create_pmap_obj(Object *root, u64 count);
+
+// The value of the key, nullptr if it's not in the map
+Object *pmap_lookup(Object *map, ObjectHash hash, Object *key);
+// The map with the key set to the value
+Object *pmap_assoc(Object *map, ObjectHash hash, Object *key, Object *value);
+// The map without the key
+Object *pmap_dissoc(Object *map, ObjectHash hash, Object *key);
+
+Object *hash_table_to_pmap(Object *ht);
+Object *pmap_to_hash_table(Object *map);
+
+inline u32 map_node_pairs(Object const *node) {
+  auto &n = node->val.node_value;
+  if (node->flags & OF_COLLISIONS) return n.datamap;
+  return std::popcount(n.datamap);
+}
+
+// Number of items of the node, 2 per pair
+inline u32 map_node_size(Object const *node) {
+  return 2 * map_node_pairs(node) +
+         std::popcount(node->val.node_value.nodemap);
+}
+
+template <typename F>
+void map_node_for_each(Object *node, F &f) {
+  auto *items = node->val.node_value.items;
+  u32 pairs = map_node_pairs(node);
+  for (u32 i = 0; i < pairs; ++i) f(items[2 * i], items[2 * i + 1]);
+  for (u32 i = 2 * pairs; i < map_node_size(node); ++i) {
+    map_node_for_each(items[i], f);
+  }
+}
+
+// Calls f with the key and the value of every entry
+template <typename F>
+void pmap_for_each(Object *map, F f) {
+  if (auto *root = map->val.pmap_value.root) map_node_for_each(root, f);
+}
+
+#endif
@@ -0,0 +1,84 @@
+#include "structs.hpp"
+
+#include "interpreter.hpp"
+
+char const *struct_op_name(StructOp const *op) { return op->name.c_str(); }
+
+Object *create_struct_obj(StructType const *type, Object **values) {
+  u32 size = type->fields.size();
+  auto *res = new_object(ObjType::Struct, OF_EVALUATED);
+  res->val.struct_value.type = type;
+  res->val.struct_value.slots = new Object *[size];
+  std::copy(values, values + size, res->val.struct_value.slots);
+  // allocated black, but the slots weren't stored through the barrier
+  if (GC.phase == GCPhase::Marking) {
+    res->gc_bits &= ~GC_MARK;
+    gc_shade(res);
+  }
+  return res;
+}
+
+void bind_struct_op(StructType const *type, std::string name,
+                    StructOpKind kind, EA arity, u32 nargs, u32 slot = 0) {
+  auto *op = new StructOp{std::move(name), {}, type, kind, slot};
+  op->spec = {op->name.c_str(), arity, nargs};
+  auto *fobj = new_object(ObjType::Function, OF_STRUCT_OP | OF_EVALUATED);
+  // the cell may hold the words of a dead object
+  fobj->val = {};
+  fobj->val.sop_value = op;
+  set_global(intern(op->name), fobj);
+}
+
+StructType const *define_struct(std::string const &name,
+                                std::vector<std::string> const &fields) {
+  auto *type = new StructType{name, fields};
+  bind_struct_op(type, "make-" + name, StructOpKind::Make, EA::EQ,
+                 fields.size());
+  for (u32 i = 0; i < fields.size(); ++i) {
+    auto const &field = fields[i];
+    bind_struct_op(type, name + "-" + field, StructOpKind::Get, EA::EQ, 1, i);
+    bind_struct_op(type, "set-" + name + "-" + field, StructOpKind::Set,
+                   EA::EQ, 2, i);
+  }
+  bind_struct_op(type, name + "?", StructOpKind::Is, EA::EQ, 1);
+  return type;
+}
+
+Object *struct_op_call(Object *fobj, Object **args, u32 nargs) {
+  auto &op = *fobj->val.sop_value;
+  if (!check_arity(&op.spec, nargs)) return nil_obj;
+  switch (op.kind) {
+    case StructOpKind::Make: {
+      return create_struct_obj(op.type, args);
+    } break;
+    case StructOpKind::Is: {
+      return bool_obj_from(is_struct_of(args[0], op.type));
+    } break;
+    case StructOpKind::Get:
+    case StructOpKind::Set: {
+      if (auto *res = struct_slot_access(fobj, args)) return res;
+      std::string got = obj_type_to_str(obj_type(args[0]));
+      if (obj_type(args[0]) == ObjType::Struct) {
+        got = args[0]->val.struct_value.type->name;
+        if (got == op.type->name) got += " of an earlier defstruct";
+      }
+      error_msg(format("\"{}\" expects a {}, got {}", op.name, op.type->name,
+                       got));
+      return nil_obj;
+    } break;
+  }
+  return nil_obj;
+}
+
+std::string *struct_to_string(Object *record) {
+  auto *type = record->val.struct_value.type;
+  auto *slots = record->val.struct_value.slots;
+  auto *res = new std::string("(" + type->name);
+  for (u32 i = 0; i < type->fields.size(); ++i) {
+    auto *value_s = obj_to_string_bare(slots[i]);
+    *res += " (" + type->fields[i] + " " + *value_s + ")";
+    delete value_s;
+  }
+  *res += ")";
+  return res;
+}
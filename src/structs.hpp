@@ -0,0 +1,68 @@
+#ifndef STRUCTS_HPP
+#define STRUCTS_HPP
+
+#include <string>
+#include <vector>
+
+#include "objects.hpp"
+#include "types.hpp"
+
+// Records defined with (defstruct name field...). Their slots are stored in
+// one array, in the order of the fields, and the functions defstruct binds
+// index them directly:
+//   (make-name value...)       the constructor, one value per field
+//   (name-field record)        the accessor of each field
+//   (set-name-field record v)  the setter of each field, returns v
+//   (name? obj)                the predicate
+// The compiler turns the calls to accessors and setters into slot loads and
+// stores, guarded by the type of the record (see Op::SlotAccess). Types and
+// their functions live as long as the interpreter, defining a struct again
+// makes a new type its older records aren't of.
+
+struct StructType {
+  std::string name;
+  std::vector<std::string> fields;
+};
+
+enum class StructOpKind : u8 { Make, Get, Set, Is };
+
+// What a function defstruct binds does. The spec gives its name and arity
+// like the ones of built-ins.
+struct StructOp {
+  std::string name;
+  BuiltinSpec spec;
+  StructType const *type;
+  StructOpKind kind;
+  u32 slot;
+};
+
+// Defines the type and binds its functions
+StructType const *define_struct(std::string const &name,
+                                std::vector<std::string> const &fields);
+
+inline u32 struct_size(Object const *record) {
+  return record->val.struct_value.type->fields.size();
+}
+
+inline bool is_struct_of(Object *obj, StructType const *type) {
+  return obj_type(obj) == ObjType::Struct &&
+         obj->val.struct_value.type == type;
+}
+
+// Calls the struct function with already evaluated arguments
+Object *struct_op_call(Object *fobj, Object **args, u32 nargs);
+
+// Result of a call to an accessor or setter on the right type of record,
+// nullptr if the record isn't of its type
+inline Object *struct_slot_access(Object *fobj, Object **args) {
+  auto &op = *fobj->val.sop_value;
+  if (!is_struct_of(args[0], op.type)) return nullptr;
+  auto *slots = args[0]->val.struct_value.slots;
+  if (op.kind == StructOpKind::Get) return slots[op.slot];
+  gc_write_barrier(args[0], args[1]);
+  return slots[op.slot] = args[1];
+}
+
+std::string *struct_to_string(Object *record);
+
+#endif
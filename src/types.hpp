@@ -1,9 +1,15 @@
 #ifndef TYPES_HPP
 #define TYPES_HPP
 
+using i8 = signed char;
+using u8 = unsigned char;
+using u16 = unsigned short;
 using u32 = unsigned int;
 using i32 = int;
 using i64 = long long int;
 using u64 = unsigned long long int;
 
+// Dense index of an interned symbol name
+using SymbolId = u32;
+
 #endif
@@ -0,0 +1,444 @@
+#include "vm.hpp"
+
+#include <fmt/core.h>
+
+#include <string>
+#include <vector>
+
+#include "errors.hpp"
+#include "gc.hpp"
+#include "interpreter.hpp"
+#include "memo.hpp"
+#include "objects.hpp"
+#include "structs.hpp"
+
+using fmt::format;
+using std::chrono::duration;
+using std::chrono::high_resolution_clock;
+
+VirtualMachine VM;
+
+void init_vm() {
+  size_t stack_size = VM.budget / sizeof(Object *);
+  VM.stack = new Object *[stack_size];
+  VM.sp = VM.stack;
+  VM.stack_end = VM.stack + stack_size;
+}
+
+inline bool is_compiled_fobj(Object *obj) {
+  return obj_type(obj) == ObjType::Function && (obj_flags(obj) & OF_COMPILED);
+}
+
+// Whether the callee collects its k-th argument into the variadic list
+inline bool takes_raw_rest_at(Object *callee, u32 k) {
+  if (!is_compiled_fobj(callee)) return false;
+  auto *proto = callee->val.cf_value.proto;
+  return proto->variadic && proto->params.size() <= k;
+}
+
+// Whether a frame of the function starting at frame fits in the budget
+inline bool frame_fits(Proto *proto, Object **frame) {
+  Object **frame_end = frame + proto->nslots + proto->chunk.max_stack;
+  size_t used = (frame_end - VM.stack) * sizeof(Object *) +
+                VM.frames.size() * sizeof(CallFrame);
+  if (frame_end <= VM.stack_end && used <= VM.budget) return true;
+  error_msg(format("Stack budget of {} MB exhausted (see --stack-mb)",
+                   VM.budget >> 20));
+  return false;
+}
+
+// Sets up the frame of a compiled function over its arguments, which are the
+// first nargs values of the frame. Returns the environment to run it in
+// through env.
+bool enter_frame(Object *fobj, Object **frame, u32 nargs, Object **env) {
+  auto *proto = fobj->val.cf_value.proto;
+  if (proto->bad_arglist) {
+    printf(
+        "apply (.) operator in function definition incorrectly placed. "
+        "It should be at the pre-last position, followed by a vararg "
+        "list argument name\n");
+    return false;
+  }
+  u32 nparams = proto->params.size();
+  u32 nlocals_from = nparams;
+  if (proto->variadic) {
+    auto *varg_lobj = create_data_list_obj();
+    for (u32 i = nparams; i < nargs; ++i) {
+      list_append_inplace(varg_lobj, frame[i]);
+    }
+    // Fill in nils for the arguments that weren't provided
+    for (u32 i = nargs; i < nparams; ++i) frame[i] = nil_obj;
+    frame[nparams] = varg_lobj;
+    ++nlocals_from;
+  } else {
+    for (u32 i = nargs; i < nparams; ++i) frame[i] = nil_obj;
+  }
+  // the extra arguments are overwritten by the locals
+  for (u32 i = nlocals_from; i < proto->nslots; ++i) frame[i] = nil_obj;
+  *env = fobj->val.cf_value.env;
+  if (proto->owns_env) *env = create_env_obj(*env, frame, proto->nslots);
+  return true;
+}
+
+// Runs a compiled function over its arguments on the top of the VM stack.
+// Only used when entering the VM from native code, which nests the C++ stack
+// and so is still limited by MAX_STACK_SIZE.
+Object *call_compiled(Object *fobj, Object **frame, u32 nargs) {
+  if (call_stack_size > MAX_STACK_SIZE) {
+    error_msg("Max call stack size reached");
+    return nil_obj;
+  }
+  auto *proto = fobj->val.cf_value.proto;
+  Object *env;
+  if (!frame_fits(proto, frame) || !enter_frame(fobj, frame, nargs, &env)) {
+    return nil_obj;
+  }
+  ++call_stack_size;
+  auto *res = vm_exec(proto, frame, env);
+  --call_stack_size;
+  return res;
+}
+
+// Calls a function with the arguments on the top of the VM stack
+Object *vm_call(Object *fobj, Object **args, u32 nargs) {
+  if (obj_type(fobj) != ObjType::Function) {
+    auto *s = obj_to_string_bare(fobj);
+    error_msg(format("\"{}\" is not callable", s->data()));
+    delete s;
+    return nil_obj;
+  }
+  if (obj_flags(fobj) & OF_SPECIAL) {
+    error_msg(format("Special form \"{}\" can only be called directly",
+                     fun_name(fobj)));
+    return nil_obj;
+  }
+  if (obj_flags(fobj) & OF_BUILTIN) {
+    if (!check_builtin_arity(fobj, nargs)) return nil_obj;
+    return fobj->val.bf_value.builtin_handler(args, nargs);
+  }
+  if (obj_flags(fobj) & OF_MEMOIZED) return memo_call(fobj, args, nargs);
+  if (obj_flags(fobj) & OF_STRUCT_OP) return struct_op_call(fobj, args, nargs);
+  if (!(obj_flags(fobj) & OF_COMPILED)) {
+    error_msg(format("Function \"{}\" wasn't compiled", fun_name(fobj)));
+    return nil_obj;
+  }
+  return call_compiled(fobj, args, nargs);
+}
+
+Object *vm_apply(Object *fobj, Object **args, u32 nargs) {
+  // the arguments become the callee's frame, so they're copied on the stack
+  if (VM.sp + nargs > VM.stack_end) {
+    error_msg(format("Stack budget of {} MB exhausted (see --stack-mb)",
+                     VM.budget >> 20));
+    return nil_obj;
+  }
+  Object **frame = VM.sp;
+  for (u32 i = 0; i < nargs; ++i) frame[i] = args[i];
+  VM.sp += nargs;
+  auto *res = vm_call(fobj, frame, nargs);
+  VM.sp = frame;
+  return res;
+}
+
+Object *vm_exec(Proto *proto, Object **frame, Object *env) {
+  u32 const *code = proto->chunk.code.data();
+  Object *const *consts = proto->chunk.consts.data();
+  Object **sp = frame + proto->nslots;
+  u32 pc = 0;
+  // Tail calls drop the callee from the stack, it's kept here instead
+  Object *fobj = nullptr;
+  // Frames of the calls made from here are pushed above this level
+  size_t base_level = VM.frames.size();
+  Object **base_frame = frame;
+  // Running out of stack abandons the evaluation up to the native caller
+  auto unwind = [&]() {
+    VM.frames.erase(VM.frames.begin() + base_level, VM.frames.end());
+    VM.sp = base_frame;
+    return nil_obj;
+  };
+  // Native code may reach a safepoint, so the current function is saved for
+  // the collector like it is for compiled calls
+  auto call_native = [&](auto call) {
+    VM.frames.push_back({proto, pc, frame, env, fobj});
+    auto *res = call();
+    VM.frames.pop_back();
+    return res;
+  };
+  auto safepoint = [&]() {
+    if (gc_wanted()) {
+      VM.sp = sp;
+      call_native([&]() {
+        gc_step(env);
+        return nil_obj;
+      });
+    }
+  };
+  while (true) {
+    u32 instr = code[pc++];
+    u32 arg = instr_arg(instr);
+    switch (instr_op(instr)) {
+      case Op::Const: {
+        *sp++ = consts[arg];
+      } break;
+      case Op::LoadGlobal: {
+        *sp++ = get_global(arg);
+      } break;
+      case Op::StoreGlobal: {
+        set_global(arg, *--sp);
+      } break;
+      case Op::LoadLocal: {
+        *sp++ = frame[arg];
+      } break;
+      case Op::StoreLocal: {
+        frame[arg] = *--sp;
+      } break;
+      case Op::LoadEnv: {
+        *sp++ = env_slot(env, arg >> 16, arg & 0xFFFF);
+      } break;
+      case Op::StoreEnv: {
+        env_set_slot(env, arg >> 16, arg & 0xFFFF, *--sp);
+      } break;
+      case Op::Pop: {
+        --sp;
+      } break;
+      case Op::Dup: {
+        *sp = sp[-1];
+        ++sp;
+      } break;
+      case Op::Jump: {
+        pc = arg;
+      } break;
+      case Op::JumpIfFalse: {
+        if (!is_truthy(*--sp)) pc = arg;
+      } break;
+      case Op::ForCount: {
+        i64 i = num_value(sp[-1]);
+        auto *limit = sp[-2];
+        if (obj_type(limit) != ObjType::Number) {
+          error_msg(format("dotimes expects a number of times, got \"{}\"",
+                           obj_type_to_str(obj_type(limit))));
+          pc = arg;
+        } else if (i >= num_value(limit)) {
+          pc = arg;
+        } else {
+          sp[-1] = create_num_obj(i + 1);
+          *sp++ = create_num_obj(i);
+        }
+      } break;
+      case Op::ForMember: {
+        i64 i = num_value(sp[-1]);
+        auto *list = sp[-2];
+        if (list != nil_obj && !is_list(list)) {
+          error_msg(format("dolist expects a list, got \"{}\"",
+                           obj_type_to_str(obj_type(list))));
+          pc = arg;
+        } else if (list == nil_obj || (size_t)i >= list_length(list)) {
+          pc = arg;
+        } else {
+          sp[-1] = create_num_obj(i + 1);
+          *sp++ = list_index(list, i);
+        }
+      } break;
+      case Op::RestGuard: {
+        auto *call_expr = consts[code[pc]];
+        u32 nfixed = code[pc + 1];
+        u32 target = code[pc + 2];
+        pc += 3;
+        // the callee sits below the arguments evaluated so far
+        if (takes_raw_rest_at(sp[-(int)arg - 1], arg)) {
+          auto items = list_members(call_expr);
+          for (u32 i = arg; i < nfixed; ++i) {
+            *sp++ = items[i + 1];
+          }
+          pc = target;
+        }
+      } break;
+      case Op::CallBuiltin:
+      case Op::SlotAccess: {
+        auto *known = consts[code[pc++]];
+        Object **args = sp - arg;
+        if (args[-1] != known) {
+          // rebound since, called the usual way
+        } else if (instr_op(instr) == Op::SlotAccess) {
+          if (auto *res = struct_slot_access(known, args)) {
+            sp = args - 1;
+            *sp++ = res;
+            break;
+          }
+        } else {
+          safepoint();
+          VM.sp = sp;
+          auto *handler = known->val.bf_value.builtin_handler;
+          auto *res = call_native([&]() { return handler(args, arg); });
+          sp = args - 1;
+          *sp++ = res;
+          break;
+        }
+      }
+        [[fallthrough]];
+      case Op::Call:
+      case Op::CallSpread: {
+        safepoint();
+        u32 nargs = arg;
+        if (instr_op(instr) == Op::CallSpread) {
+          auto *to_spread = *--sp;
+          --nargs;
+          if (!is_list(to_spread)) {
+            error_msg(
+                "dot operator on caller side should always be "
+                "followed by a list argument");
+            sp -= nargs + 1;
+            *sp++ = nil_obj;
+            break;
+          }
+          auto items = list_members(to_spread);
+          if (sp + items.size() > VM.stack_end) {
+            error_msg(format("Stack budget of {} MB exhausted (see --stack-mb)",
+                             VM.budget >> 20));
+            return unwind();
+          }
+          for (auto *item : items) *sp++ = item;
+          nargs += items.size();
+        }
+        Object **args = sp - nargs;
+        auto *callee = args[-1];
+        if (!is_compiled_fobj(callee)) {
+          VM.sp = sp;
+          auto *res =
+              call_native([&]() { return vm_call(callee, args, nargs); });
+          sp = args - 1;
+          *sp++ = res;
+          break;
+        }
+        auto *callee_proto = callee->val.cf_value.proto;
+        if (!frame_fits(callee_proto, args)) return unwind();
+        Object *callee_env;
+        VM.sp = sp;
+        if (!enter_frame(callee, args, nargs, &callee_env)) {
+          sp = args - 1;
+          *sp++ = nil_obj;
+          break;
+        }
+        VM.frames.push_back({proto, pc, frame, env, fobj});
+        fobj = callee;
+        proto = callee_proto;
+        code = proto->chunk.code.data();
+        consts = proto->chunk.consts.data();
+        frame = args;
+        env = callee_env;
+        sp = frame + proto->nslots;
+        pc = 0;
+      } break;
+      case Op::TailCall: {
+        safepoint();
+        Object **args = sp - arg;
+        auto *callee = args[-1];
+        if (!is_compiled_fobj(callee)) {
+          // the following Return passes the result on
+          VM.sp = sp;
+          auto *res =
+              call_native([&]() { return vm_call(callee, args, arg); });
+          sp = args - 1;
+          *sp++ = res;
+          break;
+        }
+        auto *callee_proto = callee->val.cf_value.proto;
+        if (!frame_fits(callee_proto, frame)) return unwind();
+        // the arguments become the new frame in place of the current one
+        for (u32 i = 0; i < arg; ++i) frame[i] = args[i];
+        VM.sp = frame + arg;
+        if (!enter_frame(callee, frame, arg, &env)) {
+          // only the jumps to the following Return are left to run
+          sp = args - 1;
+          *sp++ = nil_obj;
+          break;
+        }
+        fobj = callee;
+        proto = callee_proto;
+        code = proto->chunk.code.data();
+        consts = proto->chunk.consts.data();
+        sp = frame + proto->nslots;
+        pc = 0;
+      } break;
+      case Op::CallSpecial: {
+        auto *sf = consts[code[pc++]];
+        VM.sp = sp;
+        *sp++ = call_native(
+            [&]() { return sf->val.bf_value.special_handler(consts[arg]); });
+      } break;
+      case Op::MakeFunction: {
+        auto *fproto = proto->chunk.protos[arg];
+        *sp++ = create_compiled_fobj(fproto, env, fproto->is_lambda);
+      } break;
+      case Op::TimerStart: {
+        VM.timers.push_back(high_resolution_clock::now());
+      } break;
+      case Op::TimerStop: {
+        duration<double, std::milli> ms_double =
+            high_resolution_clock::now() - VM.timers.back();
+        VM.timers.pop_back();
+        auto *rtime_s = new std::string(std::to_string(ms_double.count()));
+        *sp++ = create_str_obj(rtime_s);
+      } break;
+      case Op::LiteralGuard: {
+        auto *lit = consts[arg];
+        u32 target = code[pc++];
+        if (obj_flags(lit) & OF_EVALUATED) {
+          *sp++ = lit;
+          pc = target;
+        }
+      } break;
+      case Op::FillLiteral: {
+        auto *lit = consts[arg];
+        auto items = list_members(lit);
+        sp -= items.size();
+        for (size_t i = 0; i < items.size(); ++i) {
+          gc_write_barrier(lit, sp[i]);
+          items[i] = sp[i];
+        }
+        lit->flags |= OF_EVALUATED;
+        *sp++ = lit;
+      } break;
+      case Op::Return: {
+        auto *res = sp[-1];
+        if (VM.frames.size() == base_level) {
+          VM.sp = frame;
+          return res;
+        }
+        // the result replaces the callee below the frame
+        frame[-1] = res;
+        sp = frame;
+        auto &caller = VM.frames.back();
+        proto = caller.proto;
+        code = proto->chunk.code.data();
+        consts = proto->chunk.consts.data();
+        pc = caller.pc;
+        frame = caller.frame;
+        env = caller.env;
+        fobj = caller.fobj;
+        VM.frames.pop_back();
+      } break;
+    }
+  }
+}
+
+Object *vm_eval(Object *expr) {
+  // the functions the form defined keep their own protos
+  auto *proto = compile_toplevel(expr);
+  auto *res = vm_run_toplevel(proto);
+  release_proto(proto);
+  return res;
+}
+
+Object *vm_run_toplevel(Proto *proto) {
+  Object **frame = VM.sp;
+  if (!frame_fits(proto, frame)) return nil_obj;
+  for (u32 i = 0; i < proto->nslots; ++i) frame[i] = nil_obj;
+  Object *env = nullptr;
+  if (proto->owns_env) env = create_env_obj(nullptr, frame, proto->nslots);
+  // its holder may let go of it while it runs, see eval_string
+  retain_proto(proto);
+  auto *res = vm_exec(proto, frame, env);
+  release_proto(proto);
+  return res;
+}
@@ -0,0 +1,68 @@
+#ifndef VM_HPP
+#define VM_HPP
+
+#include <stdlib.h>
+
+#include <chrono>
+#include <vector>
+
+#include "compiler.hpp"
+#include "types.hpp"
+
+struct Object;
+
+// Default limit for the memory used by the VM stack and call frames
+const size_t DEFAULT_STACK_BUDGET_MB = 512;
+
+// Return address of a compiled function call in progress, also saved around
+// calls into native code so the collector finds the caller's environment
+struct CallFrame {
+  Proto *proto;
+  u32 pc;
+  Object **frame;
+  Object *env;
+  // The function running, which holds the proto. nullptr for top-level
+  // forms and the functions native code called, held by their callers.
+  Object *fobj;
+};
+
+struct VirtualMachine {
+  // Bytes the stack and the call frames may use. The whole stack is
+  // reserved up front, the memory is only touched as it's used.
+  size_t budget = DEFAULT_STACK_BUDGET_MB << 20;
+  Object **stack = nullptr;
+  // first free slot
+  Object **sp = nullptr;
+  Object **stack_end = nullptr;
+  // Calls between compiled functions don't recurse in C++, the callers
+  // are kept here instead
+  std::vector<CallFrame> frames;
+  // start times of the timeit forms being run
+  std::vector<std::chrono::high_resolution_clock::time_point> timers;
+};
+
+extern VirtualMachine VM;
+
+void init_vm();
+// Runs compiled code over the frame slots (on the VM stack) in the given
+// environment
+Object *vm_exec(Proto *proto, Object **frame, Object *env);
+// Calls a function object with already evaluated arguments
+Object *vm_apply(Object *fobj, Object **args, u32 nargs);
+// Compiles and runs a top-level form
+Object *vm_eval(Object *expr);
+// Runs a compiled top-level form, see compile_toplevel
+Object *vm_run_toplevel(Proto *proto);
+
+// Keeps an object that native code holds alive while it calls back into
+// the VM, on the VM stack the collector scans. Returns false when the
+// stack is full. Pop the roots in reverse order.
+inline bool vm_push_root(Object *obj) {
+  if (VM.sp == VM.stack_end) return false;
+  *VM.sp++ = obj;
+  return true;
+}
+
+inline void vm_pop_root() { --VM.sp; }
+
+#endif
@@ -16,36 +16,39 @@
 (defun (gigabytes nb)
     (/ nb 1000000000))
 
-(defun (append list1 list2)
+;; The list library is built in, these are the same functions on top of
+;; car, cdr and cons to test the built-ins against
+
+(defun (lisp-append list1 list2)
     (if (null? list1)
         list2
-        (cons (car list1) (append (cdr list1) list2))))
+        (cons (car list1) (lisp-append (cdr list1) list2))))
 
-(defun (length items)
+(defun (lisp-length items)
     (defun (length-iter a count)
         (if (null? a)
             count
           (length-iter (cdr a) (+ 1 count))))
      (length-iter items 0))
 
-(defun (reverse l)
+(defun (lisp-reverse l)
     (if (null? l)
         '()
-        (cons (reverse (cdr l)) (car l))))
+        (cons (lisp-reverse (cdr l)) (car l))))
 
-(defun (map p l)
+(defun (lisp-map p l)
     (if (null? l)
         '()
-        (cons (p (car l)) (map p (cdr l)))))
+        (cons (p (car l)) (lisp-map p (cdr l)))))
 
-(defun (for-each p l)
+(defun (lisp-for-each p l)
     (if (null? l)
        nil
        (begin
          (p (car l))
-         (for-each p (cdr l)))))
+         (lisp-for-each p (cdr l)))))
 
-(defun (accumulate p l b)
+(defun (lisp-accumulate p l b)
     (if (null? l)
         b
-        (p (accumulate p (cdr l) b) (car l))))
+        (p (lisp-accumulate p (cdr l) b) (car l))))
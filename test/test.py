@@ -22,6 +22,15 @@ COL_WARNING = "\033[93m"
 COL_FAIL = "\033[91m"
 COL_ENDC = "\033[0m"
 
+# Examples run again with each of these lists of interpreter arguments,
+# their output must be the same
+SAME_OUTPUT_WITH = {
+    "loops.lisp": [["--tree-walk"]],
+    "num_vectors.lisp": [["--no-simd"]],
+    "constant_folding.lisp": [["--no-fold"]],
+    "gc_pacing.lisp": [["--gc-pause-ms", "0.0001"]],
+}
+
 
 def fmt_num_word(word, num):
     if num == 1:
@@ -30,6 +39,8 @@ def fmt_num_word(word, num):
 
 
 def main():
+    # Extra arguments are passed to the interpreter, e.g. --tree-walk
+    interp_args = sys.argv[1:]
     print("Running examples from {}".format(EXAMPLES_DIR))
     example_files = os.listdir(EXAMPLES_DIR)
     tests_to_process = len(example_files)
@@ -47,68 +58,78 @@ def main():
                 with open(ifp, "r") as f:
                     input_s = f.read()
                     input_args["input"] = input_s
-            # Compare to the expected output
-            test_output_file = os.path.join(EXAMPLES_OUT_DIR, ef + ".out")
-            try:
-                with open(test_output_file, "r") as tof:
-                    res = subprocess.run(
-                        [INTERP_PATH, fp],
-                        stdout=subprocess.PIPE,
-                        stderr=subprocess.PIPE,
-                        text=True,
-                        **input_args
-                    )
-                    print("Running {}".format(ef), end="")
-                    got = res.stdout
-                    same = True
-                    expected = tof.read()
-                    got_it = iter(got.splitlines())
-                    expected_it = iter(expected.splitlines())
-                    test_comparison = ""
-                    add_newline = False
-                    while True:
-                        el = next(expected_it, None)
-                        el = el.strip() if el is not None else None
-                        gl = next(got_it, None)
-                        gl = gl.strip() if gl is not None else None
-                        if not el and not gl:
-                            # Nothing left to compare, just exit
-                            break
-                        if el is None or gl is None:
-                            same = False
-                        else:
-                            if add_newline:
-                                test_comparison += "\n"
-                            for i in range(len(el)):
-                                if i >= len(gl):
-                                    same = False
-                                    test_comparison += COL_FAIL + el[i] + COL_ENDC
-                                else:
-                                    if el[i] != gl[i]:
+            # Compare to the expected output, of every run of the example
+            runs = [interp_args]
+            for extra_args in SAME_OUTPUT_WITH.get(ef, []):
+                if extra_args[0] not in interp_args:
+                    runs.append([*interp_args, *extra_args])
+            for run_args in runs:
+                test_output_file = os.path.join(EXAMPLES_OUT_DIR, ef + ".out")
+                try:
+                    with open(test_output_file, "r") as tof:
+                        res = subprocess.run(
+                            [INTERP_PATH, *run_args, fp],
+                            stdout=subprocess.PIPE,
+                            stderr=subprocess.PIPE,
+                            text=True,
+                            **input_args
+                        )
+                        print(
+                            "Running {}{}".format(
+                                ef, "".join(" " + a for a in run_args)
+                            ),
+                            end="",
+                        )
+                        got = res.stdout
+                        same = True
+                        expected = tof.read()
+                        got_it = iter(got.splitlines())
+                        expected_it = iter(expected.splitlines())
+                        test_comparison = ""
+                        add_newline = False
+                        while True:
+                            el = next(expected_it, None)
+                            el = el.strip() if el is not None else None
+                            gl = next(got_it, None)
+                            gl = gl.strip() if gl is not None else None
+                            if not el and not gl:
+                                # Nothing left to compare, just exit
+                                break
+                            if el is None or gl is None:
+                                same = False
+                            else:
+                                if add_newline:
+                                    test_comparison += "\n"
+                                for i in range(len(el)):
+                                    if i >= len(gl):
                                         same = False
-                                        test_comparison += COL_FAIL + gl[i] + COL_ENDC
+                                        test_comparison += COL_FAIL + el[i] + COL_ENDC
                                     else:
-                                        test_comparison += (
-                                            COL_OKGREEN + gl[i] + COL_ENDC
-                                        )
-                            if len(el) < len(gl):
-                                same = False
-                                test_comparison += COL_FAIL + gl[len(el) :] + COL_ENDC
-                            add_newline = True
-                    if same:
-                        print("... {}Test passed{}".format(COL_OKGREEN, COL_ENDC))
-                        succeeded += 1
-                    else:
-                        print("... {}Test failed{}".format(COL_FAIL, COL_ENDC))
-                        print(COL_OKGREEN + "- Expected:")
-                        print(expected + COL_ENDC)
-                        print("- Got:")
-                        print(test_comparison)
-                        failed += 1
-                processed += 1
-            except OSError as e:
-                # Just skip the test suite if there is no output file found
-                continue
+                                        if el[i] != gl[i]:
+                                            same = False
+                                            test_comparison += COL_FAIL + gl[i] + COL_ENDC
+                                        else:
+                                            test_comparison += (
+                                                COL_OKGREEN + gl[i] + COL_ENDC
+                                            )
+                                if len(el) < len(gl):
+                                    same = False
+                                    test_comparison += COL_FAIL + gl[len(el) :] + COL_ENDC
+                                add_newline = True
+                        if same:
+                            print("... {}Test passed{}".format(COL_OKGREEN, COL_ENDC))
+                            succeeded += 1
+                        else:
+                            print("... {}Test failed{}".format(COL_FAIL, COL_ENDC))
+                            print(COL_OKGREEN + "- Expected:")
+                            print(expected + COL_ENDC)
+                            print("- Got:")
+                            print(test_comparison)
+                            failed += 1
+                    processed += 1
+                except OSError as e:
+                    # Just skip the test suite if there is no output file found
+                    continue
     print("Processed {} tests".format(processed))
     print(
         "{}{} {} succeeded{}".format(